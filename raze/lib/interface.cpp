@@ -11,6 +11,7 @@
 #include <raze/lib/blocks.hpp>
 #include <raze/lib/numbers.hpp>
 #include <raze/lib/work.hpp>
+#include <raze/secure.hpp>
 
 #include <cstring>
 
@@ -126,6 +127,82 @@ char * raze_work_transaction (const char * transaction)
 	return result;
 }
 
+raze_ledger raze_ledger_open (const char * path)
+{
+	auto error (false);
+	std::unique_ptr<raze::block_store> store (new raze::block_store (error, boost::filesystem::path (path) / "data.ldb", 128, true));
+	return error ? nullptr : store.release ();
+}
+
+void raze_ledger_close (raze_ledger ledger)
+{
+	delete reinterpret_cast<raze::block_store *> (ledger);
+}
+
+int raze_ledger_account_info (raze_ledger ledger, const raze_uint256 account, struct raze_account_info * info)
+{
+	auto & store (*reinterpret_cast<raze::block_store *> (ledger));
+	auto const & account_l (*reinterpret_cast<raze::uint256_union const *> (account));
+	raze::transaction transaction (store.environment, nullptr, false);
+	raze::account_info info_l;
+	auto error (store.account_get (transaction, account_l, info_l));
+	if (!error)
+	{
+		std::copy (info_l.head.bytes.begin (), info_l.head.bytes.end (), info->head);
+		std::copy (info_l.rep_block.bytes.begin (), info_l.rep_block.bytes.end (), info->rep_block);
+		std::copy (info_l.open_block.bytes.begin (), info_l.open_block.bytes.end (), info->open_block);
+		std::copy (info_l.balance.bytes.begin (), info_l.balance.bytes.end (), info->balance);
+		info->modified = info_l.modified;
+		info->block_count = info_l.block_count;
+	}
+	return error ? 1 : 0;
+}
+
+size_t raze_ledger_block (raze_ledger ledger, const raze_uint256 hash, unsigned char * type, unsigned char * destination, size_t size)
+{
+	auto & store (*reinterpret_cast<raze::block_store *> (ledger));
+	auto const & hash_l (*reinterpret_cast<raze::uint256_union const *> (hash));
+	raze::transaction transaction (store.environment, nullptr, false);
+	raze::block_type type_l;
+	auto value (store.block_get_raw (transaction, hash_l, type_l));
+	if (value.mv_size != 0)
+	{
+		*type = static_cast<unsigned char> (type_l);
+		if (value.mv_size <= size)
+		{
+			std::memcpy (destination, value.mv_data, value.mv_size);
+		}
+	}
+	return value.mv_size;
+}
+
+void raze_ledger_pending (raze_ledger ledger, const raze_uint256 account, raze_pending_callback callback, void * context)
+{
+	auto & store (*reinterpret_cast<raze::block_store *> (ledger));
+	auto const & account_l (*reinterpret_cast<raze::uint256_union const *> (account));
+	raze::transaction transaction (store.environment, nullptr, false);
+	auto done (false);
+	for (auto i (store.pending_begin (transaction, raze::pending_key (account_l, 0))), n (store.pending_end ()); !done && i != n && raze::pending_key (i->first).account == account_l; ++i)
+	{
+		raze::pending_key key (i->first);
+		raze::pending_info info_l (i->second);
+		raze_pending_info pending;
+		std::copy (key.hash.bytes.begin (), key.hash.bytes.end (), pending.hash);
+		std::copy (info_l.source.bytes.begin (), info_l.source.bytes.end (), pending.source);
+		std::copy (info_l.amount.bytes.begin (), info_l.amount.bytes.end (), pending.amount);
+		done = callback (context, &pending) != 0;
+	}
+}
+
+void raze_ledger_weight (raze_ledger ledger, const raze_uint256 representative, unsigned char * weight)
+{
+	auto & store (*reinterpret_cast<raze::block_store *> (ledger));
+	auto const & representative_l (*reinterpret_cast<raze::uint256_union const *> (representative));
+	raze::transaction transaction (store.environment, nullptr, false);
+	raze::uint128_union weight_l (store.representation_get (transaction, representative_l));
+	std::copy (weight_l.bytes.begin (), weight_l.bytes.end (), weight);
+}
+
 #include <ed25519-donna/ed25519-hash-custom.h>
 void ed25519_randombytes_unsafe (void * out, size_t outlen)
 {
@@ -1,6 +1,9 @@
 #ifndef XRB_INTERFACE_H
 #define XRB_INTERFACE_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #if __cplusplus
 extern "C" {
 #endif
@@ -8,6 +11,27 @@ extern "C" {
 typedef unsigned char * raze_uint256; // 32byte array for public and private keys
 typedef unsigned char * raze_uint512; // 64byte array for signatures
 typedef void * raze_transaction;
+typedef void * raze_ledger;
+
+// Latest information about an account, amounts are 16 byte big endian numbers
+struct raze_account_info
+{
+	unsigned char head[32];
+	unsigned char rep_block[32];
+	unsigned char open_block[32];
+	unsigned char balance[16];
+	uint64_t modified;
+	uint64_t block_count;
+};
+// A send to an account that hasn't been received
+struct raze_pending_info
+{
+	unsigned char hash[32];
+	unsigned char source[32];
+	unsigned char amount[16];
+};
+// Called for each pending entry, return nonzero to stop iterating
+typedef int (*raze_pending_callback) (void * context, const struct raze_pending_info * pending);
 
 // Convert public/private key bytes 'source' to a 64 byte not-null-terminated hex string 'destination'
 void raze_uint256_to_string (const raze_uint256 source, char * destination);
@@ -39,6 +63,21 @@ char * raze_sign_transaction (const char * transaction, const raze_uint256 priva
 // Generate work for 'transaction'
 char * raze_work_transaction (const char * transaction);
 
+// Open the ledger in the data directory 'path' read only, a node may keep writing to it
+// Return null on error
+raze_ledger raze_ledger_open (const char * path);
+void raze_ledger_close (raze_ledger ledger);
+// Fill 'info' for 'account'
+// Return 0 on success, nonzero if the account isn't in the ledger
+int raze_ledger_account_info (raze_ledger ledger, const raze_uint256 account, struct raze_account_info * info);
+// Copy the serialized block 'hash' in to 'destination' if it fits in 'size' bytes and write its block type to 'type'
+// Return the serialized size, 0 if the block isn't in the ledger
+size_t raze_ledger_block (raze_ledger ledger, const raze_uint256 hash, unsigned char * type, unsigned char * destination, size_t size);
+// Call 'callback' with each pending entry for 'account' in hash order
+void raze_ledger_pending (raze_ledger ledger, const raze_uint256 account, raze_pending_callback callback, void * context);
+// Write the voting weight delegated to 'representative' in to 16 byte 'weight'
+void raze_ledger_weight (raze_ledger ledger, const raze_uint256 representative, unsigned char * weight);
+
 #if __cplusplus
 } // extern "C"
 #endif
@@ -459,6 +459,11 @@ bool raze::validate_message (raze::public_key const & public_key, raze::uint256_
 	return result;
 }
 
+void raze::validate_message_batch (unsigned char const ** m, size_t * mlen, unsigned char const ** pk, unsigned char const ** RS, size_t num, int * valid)
+{
+	ed25519_sign_open_batch (m, mlen, pk, RS, num, valid);
+}
+
 raze::uint128_union::uint128_union (std::string const & string_a)
 {
 	decode_hex (string_a);
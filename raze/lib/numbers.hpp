@@ -124,6 +124,8 @@ using signature = uint512_union;
 
 raze::uint512_union sign_message (raze::raw_key const &, raze::public_key const &, raze::uint256_union const &);
 bool validate_message (raze::public_key const &, raze::uint256_union const &, raze::uint512_union const &);
+// Check num signatures at once, valid[i] is set to 1 for each signature that verifies
+void validate_message_batch (unsigned char const **, size_t *, unsigned char const **, unsigned char const **, size_t, int *);
 void deterministic_key (raze::uint256_union const &, uint32_t, raze::uint256_union &);
 }
 
@@ -9,6 +9,9 @@ namespace raze
 {
 // Lower priority of calling work generating thread
 void work_thread_reprioritize ();
+// Keep a region out of swap, used for decrypted keys held in memory
+void memory_lock (void *, size_t);
+void memory_unlock (void *, size_t);
 template <typename... T>
 class observer_set
 {
@@ -144,7 +144,7 @@ bool raze::push_synchronization::synchronized (MDB_txn * transaction_a, raze::bl
 	return result;
 }
 
-std::unique_ptr<raze::block> raze::push_synchronization::retrieve (MDB_txn * transaction_a, raze::block_hash const & hash_a)
+std::shared_ptr<raze::block> raze::push_synchronization::retrieve (MDB_txn * transaction_a, raze::block_hash const & hash_a)
 {
 	return node.store.block_get (transaction_a, hash_a);
 }
@@ -159,7 +159,6 @@ node (node_a),
 attempt (attempt_a),
 socket (node_a->service),
 endpoint (endpoint_a),
-timeout (node_a->service),
 block_count (0),
 pending_stop (false),
 hard_stop (false),
@@ -195,19 +194,16 @@ void raze::bootstrap_client::stop (bool force)
 
 void raze::bootstrap_client::start_timeout ()
 {
-	timeout.expires_from_now (boost::posix_time::seconds (5));
+	node->alarm.cancel (timeout);
 	std::weak_ptr<raze::bootstrap_client> this_w (shared ());
-	timeout.async_wait ([this_w](boost::system::error_code const & ec) {
-		if (ec != boost::asio::error::operation_aborted)
+	timeout = node->alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [this_w]() {
+		auto this_l (this_w.lock ());
+		if (this_l != nullptr)
 		{
-			auto this_l (this_w.lock ());
-			if (this_l != nullptr)
+			this_l->socket.close ();
+			if (this_l->node->config.logging.bulk_pull_logging ())
 			{
-				this_l->socket.close ();
-				if (this_l->node->config.logging.bulk_pull_logging ())
-				{
-					BOOST_LOG (this_l->node->log) << boost::str (boost::format ("Disconnecting from %1% due to timeout") % this_l->endpoint);
-				}
+				BOOST_LOG (this_l->node->log) << boost::str (boost::format ("Disconnecting from %1% due to timeout") % this_l->endpoint);
 			}
 		}
 	});
@@ -215,8 +211,8 @@ void raze::bootstrap_client::start_timeout ()
 
 void raze::bootstrap_client::stop_timeout ()
 {
-	size_t killed (timeout.cancel ());
-	(void)killed;
+	node->alarm.cancel (timeout);
+	timeout.reset ();
 }
 
 void raze::bootstrap_client::run ()
@@ -367,8 +363,8 @@ void raze::frontier_req_client::received_frontier (boost::system::error_code con
 			while (!current.is_zero () && current < account)
 			{
 				// We know about an account they don't.
-				raze::transaction transaction (connection->node->store.environment, nullptr, true);
-				if (connection->node->wallets.exists (transaction, current))
+				raze::scheduled_transaction transaction (connection->node->write_scheduler, raze::write_priority::bulk);
+				if (connection->node->wallets.exists (current))
 				{
 					unsynced (transaction, info.head, 0);
 				}
@@ -378,7 +374,7 @@ void raze::frontier_req_client::received_frontier (boost::system::error_code con
 			{
 				if (account == current)
 				{
-					raze::transaction transaction (connection->node->store.environment, nullptr, true);
+					raze::scheduled_transaction transaction (connection->node->write_scheduler, raze::write_priority::bulk);
 					if (latest == info.head)
 					{
 						// In sync
@@ -388,7 +384,7 @@ void raze::frontier_req_client::received_frontier (boost::system::error_code con
 						if (connection->node->store.block_exists (transaction, latest))
 						{
 							// We know about a block they don't.
-							if (connection->node->wallets.exists (transaction, current))
+							if (connection->node->wallets.exists (current))
 							{
 								unsynced (transaction, info.head, latest);
 							}
@@ -415,11 +411,11 @@ void raze::frontier_req_client::received_frontier (boost::system::error_code con
 		else
 		{
 			{
-				raze::transaction transaction (connection->node->store.environment, nullptr, true);
+				raze::scheduled_transaction transaction (connection->node->write_scheduler, raze::write_priority::bulk);
 				while (!current.is_zero ())
 				{
 					// We know about an account they don't.
-					if (connection->node->wallets.exists (transaction, current))
+					if (connection->node->wallets.exists (current))
 					{
 						unsynced (transaction, info.head, 0);
 					}
@@ -665,7 +661,7 @@ void raze::bulk_push_client::start ()
 	connection->start_timeout ();
 	boost::asio::async_write (connection->socket, boost::asio::buffer (buffer->data (), buffer->size ()), [this_l, buffer](boost::system::error_code const & ec, size_t size_a) {
 		this_l->connection->stop_timeout ();
-		raze::transaction transaction (this_l->connection->node->store.environment, nullptr, true);
+		raze::scheduled_transaction transaction (this_l->connection->node->write_scheduler, raze::write_priority::bulk);
 		if (!ec)
 		{
 			this_l->push (transaction);
@@ -740,7 +736,7 @@ void raze::bulk_push_client::push_block (raze::block const & block_a)
 		this_l->connection->stop_timeout ();
 		if (!ec)
 		{
-			raze::transaction transaction (this_l->connection->node->store.environment, nullptr, true);
+			raze::scheduled_transaction transaction (this_l->connection->node->write_scheduler, raze::write_priority::bulk);
 			if (!this_l->synchronization.blocks.empty ())
 			{
 				this_l->synchronization.synchronize_one (transaction);
@@ -1621,6 +1617,10 @@ public:
 	{
 		assert (false);
 	}
+	void confirm_ack_hashes (raze::confirm_ack_hashes const &) override
+	{
+		assert (false);
+	}
 	void bulk_pull (raze::bulk_pull const &) override
 	{
 		auto response (std::make_shared<raze::bulk_pull_server> (connection, std::unique_ptr<raze::bulk_pull> (static_cast<raze::bulk_pull *> (connection->requests.front ().release ()))));
@@ -1702,7 +1702,7 @@ void raze::bulk_pull_server::set_current_end ()
 
 void raze::bulk_pull_server::send_next ()
 {
-	std::unique_ptr<raze::block> block (get_next ());
+	std::shared_ptr<raze::block> block (get_next ());
 	if (block != nullptr)
 	{
 		{
@@ -1725,9 +1725,9 @@ void raze::bulk_pull_server::send_next ()
 	}
 }
 
-std::unique_ptr<raze::block> raze::bulk_pull_server::get_next ()
+std::shared_ptr<raze::block> raze::bulk_pull_server::get_next ()
 {
-	std::unique_ptr<raze::block> result;
+	std::shared_ptr<raze::block> result;
 	if (current != request->end)
 	{
 		raze::transaction transaction (connection->node->store.environment, nullptr, false);
@@ -1841,7 +1841,7 @@ void raze::bulk_pull_blocks_server::set_params ()
 
 void raze::bulk_pull_blocks_server::send_next ()
 {
-	std::unique_ptr<raze::block> block (get_next ());
+	std::shared_ptr<raze::block> block (get_next ());
 	if (block != nullptr)
 	{
 		if (connection->node->config.logging.bulk_pull_logging ())
@@ -1899,9 +1899,9 @@ void raze::bulk_pull_blocks_server::send_next ()
 	}
 }
 
-std::unique_ptr<raze::block> raze::bulk_pull_blocks_server::get_next ()
+std::shared_ptr<raze::block> raze::bulk_pull_blocks_server::get_next ()
 {
-	std::unique_ptr<raze::block> result;
+	std::shared_ptr<raze::block> result;
 	bool out_of_bounds;
 
 	out_of_bounds = false;
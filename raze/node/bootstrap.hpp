@@ -35,7 +35,7 @@ public:
 	virtual ~block_synchronization () = default;
 	// Return true if target already has block
 	virtual bool synchronized (MDB_txn *, raze::block_hash const &) = 0;
-	virtual std::unique_ptr<raze::block> retrieve (MDB_txn *, raze::block_hash const &) = 0;
+	virtual std::shared_ptr<raze::block> retrieve (MDB_txn *, raze::block_hash const &) = 0;
 	virtual raze::sync_result target (MDB_txn *, raze::block const &) = 0;
 	// return true if all dependencies are synchronized
 	bool add_dependency (MDB_txn *, raze::block const &);
@@ -51,12 +51,13 @@ public:
 	push_synchronization (raze::node &, std::function<raze::sync_result (MDB_txn *, raze::block const &)> const &);
 	virtual ~push_synchronization () = default;
 	bool synchronized (MDB_txn *, raze::block_hash const &) override;
-	std::unique_ptr<raze::block> retrieve (MDB_txn *, raze::block_hash const &) override;
+	std::shared_ptr<raze::block> retrieve (MDB_txn *, raze::block_hash const &) override;
 	raze::sync_result target (MDB_txn *, raze::block const &) override;
 	std::function<raze::sync_result (MDB_txn *, raze::block const &)> target_m;
 	raze::node & node;
 };
 class bootstrap_client;
+class operation;
 class pull_info
 {
 public:
@@ -160,7 +161,8 @@ public:
 	boost::asio::ip::tcp::socket socket;
 	std::array<uint8_t, 200> receive_buffer;
 	raze::tcp_endpoint endpoint;
-	boost::asio::deadline_timer timeout;
+	// Closes the socket if the current request takes too long
+	std::shared_ptr<raze::operation> timeout;
 	std::chrono::steady_clock::time_point start_time;
 	std::atomic<uint64_t> block_count;
 	std::atomic<bool> pending_stop;
@@ -247,7 +249,7 @@ class bulk_pull_server : public std::enable_shared_from_this<raze::bulk_pull_ser
 public:
 	bulk_pull_server (std::shared_ptr<raze::bootstrap_server> const &, std::unique_ptr<raze::bulk_pull>);
 	void set_current_end ();
-	std::unique_ptr<raze::block> get_next ();
+	std::shared_ptr<raze::block> get_next ();
 	void send_next ();
 	void sent_action (boost::system::error_code const &, size_t);
 	void send_finished ();
@@ -263,7 +265,7 @@ class bulk_pull_blocks_server : public std::enable_shared_from_this<raze::bulk_p
 public:
 	bulk_pull_blocks_server (std::shared_ptr<raze::bootstrap_server> const &, std::unique_ptr<raze::bulk_pull_blocks>);
 	void set_params ();
-	std::unique_ptr<raze::block> get_next ();
+	std::shared_ptr<raze::block> get_next ();
 	void send_next ();
 	void sent_action (boost::system::error_code const &, size_t);
 	void send_finished ();
@@ -7,10 +7,11 @@ std::array<uint8_t, 2> constexpr raze::message::magic_number;
 size_t constexpr raze::message::ipv4_only_position;
 size_t constexpr raze::message::bootstrap_server_position;
 std::bitset<16> constexpr raze::message::block_type_mask;
+uint8_t constexpr raze::confirm_ack_hashes::version;
 
 raze::message::message (raze::message_type type_a) :
-version_max (0x06),
-version_using (0x06),
+version_max (0x07),
+version_using (0x07),
 version_min (0x01),
 type (type_a)
 {
@@ -111,6 +112,11 @@ void raze::message_parser::deserialize_buffer (uint8_t const * buffer_a, size_t
 				deserialize_confirm_ack (buffer_a, size_a);
 				break;
 			}
+			case raze::message_type::confirm_ack_hashes:
+			{
+				deserialize_confirm_ack_hashes (buffer_a, size_a);
+				break;
+			}
 			default:
 			{
 				error = true;
@@ -205,6 +211,21 @@ void raze::message_parser::deserialize_confirm_ack (uint8_t const * buffer_a, si
 	}
 }
 
+void raze::message_parser::deserialize_confirm_ack_hashes (uint8_t const * buffer_a, size_t size_a)
+{
+	bool error_l;
+	raze::bufferstream stream (buffer_a, size_a);
+	raze::confirm_ack_hashes incoming (error_l, stream);
+	if (!error_l && at_end (stream))
+	{
+		visitor.confirm_ack_hashes (incoming);
+	}
+	else
+	{
+		error = true;
+	}
+}
+
 bool raze::message_parser::at_end (raze::bufferstream & stream_a)
 {
 	uint8_t junk;
@@ -400,6 +421,61 @@ void raze::confirm_ack::visit (raze::message_visitor & visitor_a) const
 	visitor_a.confirm_ack (*this);
 }
 
+raze::confirm_ack_hashes::confirm_ack_hashes (bool & error_a, raze::stream & stream_a) :
+message (error_a, stream_a),
+vote (std::make_shared<raze::vote> (error_a, stream_a, raze::block_type::not_a_block))
+{
+}
+
+raze::confirm_ack_hashes::confirm_ack_hashes (std::shared_ptr<raze::vote> vote_a) :
+message (raze::message_type::confirm_ack_hashes),
+vote (vote_a)
+{
+	assert (!vote->hashes.empty ());
+}
+
+bool raze::confirm_ack_hashes::deserialize (raze::stream & stream_a)
+{
+	auto result (read_header (stream_a, version_max, version_using, version_min, type, extensions));
+	assert (!result);
+	assert (type == raze::message_type::confirm_ack_hashes);
+	if (!result)
+	{
+		result = read (stream_a, vote->account);
+		if (!result)
+		{
+			result = read (stream_a, vote->signature);
+			if (!result)
+			{
+				result = read (stream_a, vote->sequence);
+				if (!result)
+				{
+					vote->hashes.clear ();
+					result = vote->deserialize_hashes (stream_a);
+				}
+			}
+		}
+	}
+	return result;
+}
+
+void raze::confirm_ack_hashes::serialize (raze::stream & stream_a)
+{
+	write_header (stream_a);
+	vote->serialize (stream_a, raze::block_type::not_a_block);
+}
+
+bool raze::confirm_ack_hashes::operator== (raze::confirm_ack_hashes const & other_a) const
+{
+	auto result (*vote == *other_a.vote);
+	return result;
+}
+
+void raze::confirm_ack_hashes::visit (raze::message_visitor & visitor_a) const
+{
+	visitor_a.confirm_ack_hashes (*this);
+}
+
 raze::frontier_req::frontier_req () :
 message (raze::message_type::frontier_req)
 {
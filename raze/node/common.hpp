@@ -93,7 +93,8 @@ enum class message_type : uint8_t
 	bulk_pull,
 	bulk_push,
 	frontier_req,
-	bulk_pull_blocks
+	bulk_pull_blocks,
+	confirm_ack_hashes
 };
 enum class bulk_pull_blocks_mode : uint8_t
 {
@@ -136,6 +137,7 @@ public:
 	void deserialize_publish (uint8_t const *, size_t);
 	void deserialize_confirm_req (uint8_t const *, size_t);
 	void deserialize_confirm_ack (uint8_t const *, size_t);
+	void deserialize_confirm_ack_hashes (uint8_t const *, size_t);
 	bool at_end (raze::bufferstream &);
 	raze::message_visitor & visitor;
 	raze::work_pool & pool;
@@ -185,6 +187,19 @@ public:
 	bool operator== (raze::confirm_ack const &) const;
 	std::shared_ptr<raze::vote> vote;
 };
+// A vote covering up to vote::max_hashes block hashes under one signature, understood from protocol version 7
+class confirm_ack_hashes : public message
+{
+public:
+	confirm_ack_hashes (bool &, raze::stream &);
+	confirm_ack_hashes (std::shared_ptr<raze::vote>);
+	bool deserialize (raze::stream &) override;
+	void serialize (raze::stream &) override;
+	void visit (raze::message_visitor &) const override;
+	bool operator== (raze::confirm_ack_hashes const &) const;
+	std::shared_ptr<raze::vote> vote;
+	static uint8_t constexpr version = 0x07;
+};
 class frontier_req : public message
 {
 public:
@@ -234,6 +249,7 @@ public:
 	virtual void publish (raze::publish const &) = 0;
 	virtual void confirm_req (raze::confirm_req const &) = 0;
 	virtual void confirm_ack (raze::confirm_ack const &) = 0;
+	virtual void confirm_ack_hashes (raze::confirm_ack_hashes const &) = 0;
 	virtual void bulk_pull (raze::bulk_pull const &) = 0;
 	virtual void bulk_pull_blocks (raze::bulk_pull_blocks const &) = 0;
 	virtual void bulk_push (raze::bulk_push const &) = 0;
@@ -30,7 +30,12 @@ std::chrono::seconds constexpr raze::node::cutoff;
 std::chrono::minutes constexpr raze::node::backup_interval;
 int constexpr raze::port_mapping::mapping_timeout;
 int constexpr raze::port_mapping::check_timeout;
+unsigned constexpr raze::active_transactions::announcements_per_interval;
+unsigned constexpr raze::active_transactions::announcements_max;
 unsigned constexpr raze::active_transactions::announce_interval_ms;
+unsigned constexpr raze::active_transactions::announce_interval_min_ms;
+size_t constexpr raze::active_transactions::elections_max;
+size_t constexpr raze::active_transactions::scheduled_max;
 
 raze::message_statistics::message_statistics () :
 keepalive (0),
@@ -155,29 +160,46 @@ void raze::network::rebroadcast_reps (std::shared_ptr<raze::block> block_a)
 	}
 }
 
+namespace
+{
+std::string vote_target (raze::vote const & vote_a)
+{
+	return vote_a.hashes.empty () ? vote_a.block->hash ().to_string () : boost::str (boost::format ("%1% hashes") % vote_a.hashes.size ());
+}
+}
+
 template <typename T>
 bool confirm_block (MDB_txn * transaction_a, raze::node & node_a, T & list_a, std::shared_ptr<raze::block> block_a)
 {
 	bool result (false);
 	if (node_a.config.enable_voting)
 	{
-		node_a.wallets.foreach_representative (transaction_a, [&result, &block_a, &list_a, &node_a, &transaction_a](raze::public_key const & pub_a, raze::raw_key const & prv_a) {
+		// Peers that understand votes by hash get this block batched with others under one signature, the rest get a vote carrying the block
+		std::vector<raze::endpoint> hashed;
+		std::vector<raze::endpoint> single;
+		for (auto j (list_a.begin ()), m (list_a.end ()); j != m; ++j)
+		{
+			if (node_a.peers.vote_by_hash_aware (*j))
+			{
+				hashed.push_back (*j);
+			}
+			else
+			{
+				single.push_back (*j);
+			}
+		}
+		node_a.wallets.foreach_representative (transaction_a, [&result, &block_a, &single, &node_a, &transaction_a](raze::public_key const & pub_a, raze::raw_key const & prv_a) {
 			result = true;
-			auto votes (node_a.store.vote_generate (transaction_a, pub_a, prv_a, block_a));
-			for (auto vote : { votes.first, votes.second })
+			if (!single.empty ())
 			{
-				raze::confirm_ack confirm (vote);
-				std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
-				{
-					raze::vectorstream stream (*bytes);
-					confirm.serialize (stream);
-				}
-				for (auto j (list_a.begin ()), m (list_a.end ()); j != m; ++j)
-				{
-					node_a.network.confirm_send (confirm, bytes, *j);
-				}
+				auto vote (node_a.store.vote_generate (transaction_a, pub_a, prv_a, block_a));
+				node_a.network.vote_send (vote, single);
 			}
 		});
+		if (result && !hashed.empty ())
+		{
+			node_a.vote_generator.add (block_a->hash (), hashed);
+		}
 	}
 	return result;
 }
@@ -233,17 +255,7 @@ void raze::network::republish_vote (std::chrono::steady_clock::time_point const
 	{
 		if (node.weight (vote_a->account) > raze::Mraze_ratio * 256)
 		{
-			raze::confirm_ack confirm (vote_a);
-			std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
-			{
-				raze::vectorstream stream (*bytes);
-				confirm.serialize (stream);
-			}
-			auto list (node.peers.list_sqrt ());
-			for (auto j (list.begin ()), m (list.end ()); j != m; ++j)
-			{
-				node.network.confirm_send (confirm, bytes, *j);
-			}
+			vote_send (vote_a, node.peers.list_sqrt ());
 		}
 	}
 }
@@ -372,23 +384,29 @@ public:
 		++node.network.incoming.confirm_ack;
 		node.peers.contacted (sender, message_a.version_using);
 		node.peers.insert (sender, message_a.version_using);
-		node.process_active (message_a.vote->block);
-		auto vote (node.vote_processor.vote (message_a.vote, sender));
-		if (vote.code == raze::vote_code::replay)
+		if (!node.recent_votes.seen (message_a.vote))
 		{
-			assert (vote.vote->sequence > message_a.vote->sequence);
-			// This tries to assist rep nodes that have lost track of their highest sequence number by replaying our highest known vote back to them
-			// Only do this if the sequence number is significantly different to account for network reordering
-			// Amplify attack considerations: We're sending out a confirm_ack in response to a confirm_ack for no net traffic increase
-			if (vote.vote->sequence - message_a.vote->sequence > 10000)
+			node.process_active (message_a.vote->block);
+			if (node.vote_processor.add (message_a.vote, sender) && node.config.logging.vote_logging ())
 			{
-				raze::confirm_ack confirm (vote.vote);
-				std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
-				{
-					raze::vectorstream stream (*bytes);
-					confirm.serialize (stream);
-				}
-				node.network.confirm_send (confirm, bytes, sender);
+				BOOST_LOG (node.log) << boost::str (boost::format ("Vote processor queue full, dropping vote from: %1%") % message_a.vote->account.to_account ());
+			}
+		}
+	}
+	void confirm_ack_hashes (raze::confirm_ack_hashes const & message_a) override
+	{
+		if (node.config.logging.network_message_logging ())
+		{
+			BOOST_LOG (node.log) << boost::str (boost::format ("Received confirm_ack_hashes message from %1% for %2% hashes sequence %3%") % sender % message_a.vote->hashes.size () % std::to_string (message_a.vote->sequence));
+		}
+		++node.network.incoming.confirm_ack;
+		node.peers.contacted (sender, message_a.version_using);
+		node.peers.insert (sender, message_a.version_using);
+		if (!node.recent_votes.seen (message_a.vote))
+		{
+			if (node.vote_processor.add (message_a.vote, sender) && node.config.logging.vote_logging ())
+			{
+				BOOST_LOG (node.log) << boost::str (boost::format ("Vote processor queue full, dropping vote from: %1%") % message_a.vote->account.to_account ());
 			}
 		}
 	}
@@ -473,62 +491,205 @@ void raze::network::merge_peers (std::array<raze::endpoint, 8> const & peers_a)
 	}
 }
 
-bool raze::operation::operator> (raze::operation const & other_a) const
-{
-	return wakeup > other_a.wakeup;
-}
+unsigned constexpr raze::alarm::slot_bits;
+size_t constexpr raze::alarm::slots;
+unsigned constexpr raze::alarm::levels;
+size_t constexpr raze::alarm::dispatch_max;
 
 raze::alarm::alarm (boost::asio::io_service & service_a) :
 service (service_a),
+start (std::chrono::steady_clock::now ()),
+current (0),
+wakeup (0),
+counts (),
+stopped (false),
 thread ([this]() { run (); })
 {
 }
 
 raze::alarm::~alarm ()
 {
-	add (std::chrono::steady_clock::now (), nullptr);
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		condition.notify_all ();
+	}
 	thread.join ();
 }
 
+uint64_t raze::alarm::tick (std::chrono::steady_clock::time_point const & time_a)
+{
+	uint64_t result (0);
+	if (time_a > start)
+	{
+		result = std::chrono::duration_cast<std::chrono::milliseconds> (time_a - start).count ();
+	}
+	return result;
+}
+
+void raze::alarm::insert (std::shared_ptr<raze::operation> const & operation_a)
+{
+	assert (operation_a->tick >= current);
+	auto delta (operation_a->tick - current);
+	auto tick_l (operation_a->tick);
+	if (delta >= (uint64_t (1) << (slot_bits * levels)))
+	{
+		// Past the last level, it's put back in when that slot cascades
+		tick_l = current + (uint64_t (1) << (slot_bits * levels)) - 1;
+		delta = tick_l - current;
+	}
+	unsigned level (0);
+	while (level + 1 < levels && delta >= (uint64_t (1) << (slot_bits * (level + 1))))
+	{
+		++level;
+	}
+	wheels[level][(tick_l >> (slot_bits * level)) & (slots - 1)].push_back (operation_a);
+	++counts[level];
+}
+
+void raze::alarm::cascade (unsigned level_a)
+{
+	auto index ((current >> (slot_bits * level_a)) & (slots - 1));
+	if (index == 0 && level_a + 1 < levels)
+	{
+		cascade (level_a + 1);
+	}
+	std::vector<std::shared_ptr<raze::operation>> operations;
+	operations.swap (wheels[level_a][index]);
+	counts[level_a] -= operations.size ();
+	for (auto & i : operations)
+	{
+		if (i->function)
+		{
+			insert (i);
+		}
+	}
+}
+
 void raze::alarm::run ()
 {
 	std::unique_lock<std::mutex> lock (mutex);
-	auto done (false);
-	while (!done)
+	while (!stopped)
 	{
-		if (!operations.empty ())
+		auto now (tick (std::chrono::steady_clock::now ()));
+		std::vector<std::function<void()>> due;
+		while (current <= now)
 		{
-			auto & operation (operations.top ());
-			if (operation.function)
+			if ((current & (slots - 1)) == 0)
+			{
+				cascade (1);
+			}
+			if (counts[0] == 0)
+			{
+				// Nothing can come due before the next cascade
+				current = std::min (now + 1, (current | (slots - 1)) + 1);
+			}
+			else
 			{
-				if (operation.wakeup <= std::chrono::steady_clock::now ())
+				auto & slot (wheels[0][current & (slots - 1)]);
+				counts[0] -= slot.size ();
+				for (auto & i : slot)
 				{
-					service.post (operation.function);
-					operations.pop ();
+					if (i->function)
+					{
+						due.push_back (nullptr);
+						due.back ().swap (i->function);
+					}
 				}
-				else
+				slot.clear ();
+				++current;
+			}
+		}
+		if (!due.empty ())
+		{
+			lock.unlock ();
+			dispatch (due);
+			lock.lock ();
+		}
+		else
+		{
+			auto next (std::numeric_limits<uint64_t>::max ());
+			if (counts[0] != 0)
+			{
+				for (auto i (current), n (current + slots); i != n && next == std::numeric_limits<uint64_t>::max (); ++i)
 				{
-					auto wakeup (operation.wakeup);
-					condition.wait_until (lock, wakeup);
+					if (!wheels[0][i & (slots - 1)].empty ())
+					{
+						next = i;
+					}
+				}
+			}
+			for (auto i (1u); i < levels; ++i)
+			{
+				if (counts[i] != 0)
+				{
+					next = std::min (next, (current | (slots - 1)) + 1);
 				}
 			}
+			wakeup = next;
+			if (next == std::numeric_limits<uint64_t>::max ())
+			{
+				condition.wait (lock);
+			}
 			else
 			{
-				done = true;
+				condition.wait_until (lock, start + std::chrono::milliseconds (next));
 			}
+			wakeup = 0;
 		}
-		else
+	}
+}
+
+void raze::alarm::dispatch (std::vector<std::function<void()>> & due_a)
+{
+	for (size_t i (0), n (due_a.size ()); i < n; i += dispatch_max)
+	{
+		auto batch (std::make_shared<std::vector<std::function<void()>>> ());
+		for (auto j (i), m (std::min (n, i + dispatch_max)); j < m; ++j)
 		{
-			condition.wait (lock);
+			batch->push_back (nullptr);
+			batch->back ().swap (due_a[j]);
 		}
+		service.post ([batch]() {
+			for (auto & i : *batch)
+			{
+				i ();
+			}
+		});
 	}
 }
 
-void raze::alarm::add (std::chrono::steady_clock::time_point const & wakeup_a, std::function<void()> const & operation)
+std::shared_ptr<raze::operation> raze::alarm::add (std::chrono::steady_clock::time_point const & wakeup_a, std::function<void()> const & operation_a)
 {
+	auto result (std::make_shared<raze::operation> ());
+	result->function = operation_a;
 	std::lock_guard<std::mutex> lock (mutex);
-	operations.push (raze::operation ({ wakeup_a, operation }));
-	condition.notify_all ();
+	// Round up so nothing runs early
+	auto tick_l (tick (wakeup_a));
+	if (start + std::chrono::milliseconds (tick_l) < wakeup_a)
+	{
+		++tick_l;
+	}
+	result->tick = std::max (tick_l, current);
+	insert (result);
+	if (result->tick < wakeup)
+	{
+		condition.notify_all ();
+	}
+	return result;
+}
+
+void raze::alarm::cancel (std::shared_ptr<raze::operation> const & operation_a)
+{
+	if (operation_a != nullptr)
+	{
+		std::function<void()> function;
+		{
+			std::lock_guard<std::mutex> lock (mutex);
+			function.swap (operation_a->function);
+		}
+		// Whatever the function captured is released outside the lock
+	}
 }
 
 raze::logging::logging () :
@@ -749,6 +910,8 @@ raze::node_config::node_config (uint16_t peering_port_a, raze::logging const & l
 peering_port (peering_port_a),
 logging (logging_a),
 bootstrap_fraction_numerator (1),
+gap_cache_max (64 * 1024),
+gap_cache_purge_age (15 * 60),
 receive_minimum (raze::raze_ratio),
 inactive_supply (0),
 password_fanout (1024),
@@ -758,7 +921,10 @@ enable_voting (true),
 bootstrap_connections (4),
 bootstrap_connections_max (64),
 callback_port (0),
-lmdb_max_dbs (128)
+lmdb_max_dbs (128),
+lmdb_sync_interval (0),
+bootstrap_weights_file (""),
+read_only (false)
 {
 	switch (raze::raze_network)
 	{
@@ -791,9 +957,11 @@ lmdb_max_dbs (128)
 
 void raze::node_config::serialize_json (boost::property_tree::ptree & tree_a) const
 {
-	tree_a.put ("version", "9");
+	tree_a.put ("version", "14");
 	tree_a.put ("peering_port", std::to_string (peering_port));
 	tree_a.put ("bootstrap_fraction_numerator", std::to_string (bootstrap_fraction_numerator));
+	tree_a.put ("gap_cache_max", std::to_string (gap_cache_max));
+	tree_a.put ("gap_cache_purge_age", std::to_string (gap_cache_purge_age));
 	tree_a.put ("receive_minimum", receive_minimum.to_string_dec ());
 	boost::property_tree::ptree logging_l;
 	logging.serialize_json (logging_l);
@@ -833,6 +1001,9 @@ void raze::node_config::serialize_json (boost::property_tree::ptree & tree_a) co
 	tree_a.put ("callback_port", std::to_string (callback_port));
 	tree_a.put ("callback_target", callback_target);
 	tree_a.put ("lmdb_max_dbs", lmdb_max_dbs);
+	tree_a.put ("lmdb_sync_interval", std::to_string (lmdb_sync_interval));
+	tree_a.put ("bootstrap_weights_file", bootstrap_weights_file);
+	tree_a.put ("read_only", read_only);
 }
 
 bool raze::node_config::upgrade_json (unsigned version, boost::property_tree::ptree & tree_a)
@@ -907,6 +1078,31 @@ bool raze::node_config::upgrade_json (unsigned version, boost::property_tree::pt
 			tree_a.put ("version", "9");
 			result = true;
 		case 9:
+			tree_a.put ("lmdb_sync_interval", "0");
+			tree_a.erase ("version");
+			tree_a.put ("version", "10");
+			result = true;
+		case 10:
+			tree_a.put ("bootstrap_weights_file", "");
+			tree_a.erase ("version");
+			tree_a.put ("version", "11");
+			result = true;
+		case 11:
+			tree_a.put ("read_only", false);
+			tree_a.erase ("version");
+			tree_a.put ("version", "12");
+			result = true;
+		case 12:
+			tree_a.put ("gap_cache_max", std::to_string (64 * 1024));
+			tree_a.erase ("version");
+			tree_a.put ("version", "13");
+			result = true;
+		case 13:
+			tree_a.put ("gap_cache_purge_age", std::to_string (15 * 60));
+			tree_a.erase ("version");
+			tree_a.put ("version", "14");
+			result = true;
+		case 14:
 			break;
 		default:
 			throw std::runtime_error ("Unknown node_config version");
@@ -934,6 +1130,8 @@ bool raze::node_config::deserialize_json (bool & upgraded_a, boost::property_tre
 		upgraded_a |= upgrade_json (std::stoull (version_l.get ()), tree_a);
 		auto peering_port_l (tree_a.get<std::string> ("peering_port"));
 		auto bootstrap_fraction_numerator_l (tree_a.get<std::string> ("bootstrap_fraction_numerator"));
+		auto gap_cache_max_l (tree_a.get<std::string> ("gap_cache_max"));
+		auto gap_cache_purge_age_l (tree_a.get<std::string> ("gap_cache_purge_age"));
 		auto receive_minimum_l (tree_a.get<std::string> ("receive_minimum"));
 		auto & logging_l (tree_a.get_child ("logging"));
 		work_peers.clear ();
@@ -979,17 +1177,23 @@ bool raze::node_config::deserialize_json (bool & upgraded_a, boost::property_tre
 		auto callback_port_l (tree_a.get<std::string> ("callback_port"));
 		callback_target = tree_a.get<std::string> ("callback_target");
 		auto lmdb_max_dbs_l = tree_a.get<std::string> ("lmdb_max_dbs");
+		auto lmdb_sync_interval_l (tree_a.get<std::string> ("lmdb_sync_interval"));
+		bootstrap_weights_file = tree_a.get<std::string> ("bootstrap_weights_file");
+		read_only = tree_a.get<bool> ("read_only");
 		result |= parse_port (callback_port_l, callback_port);
 		try
 		{
 			peering_port = std::stoul (peering_port_l);
 			bootstrap_fraction_numerator = std::stoul (bootstrap_fraction_numerator_l);
+			gap_cache_max = std::stoul (gap_cache_max_l);
+			gap_cache_purge_age = std::stoul (gap_cache_purge_age_l);
 			password_fanout = std::stoul (password_fanout_l);
 			io_threads = std::stoul (io_threads_l);
 			work_threads = std::stoul (work_threads_l);
 			bootstrap_connections = std::stoul (bootstrap_connections_l);
 			bootstrap_connections_max = std::stoul (bootstrap_connections_max_l);
 			lmdb_max_dbs = std::stoi (lmdb_max_dbs_l);
+			lmdb_sync_interval = std::stoul (lmdb_sync_interval_l);
 			result |= peering_port > std::numeric_limits<uint16_t>::max ();
 			result |= logging.deserialize_json (upgraded_a, logging_l);
 			result |= receive_minimum.decode_dec (receive_minimum_l);
@@ -998,6 +1202,7 @@ bool raze::node_config::deserialize_json (bool & upgraded_a, boost::property_tre
 			result |= password_fanout > 1024 * 1024;
 			result |= io_threads == 0;
 			result |= work_threads == 0;
+			result |= gap_cache_max == 0;
 		}
 		catch (std::logic_error const &)
 		{
@@ -1019,9 +1224,58 @@ raze::account raze::node_config::random_representative ()
 	return result;
 }
 
+size_t constexpr raze::vote_processor::max_votes;
+size_t constexpr raze::vote_processor::batch_max;
+
 raze::vote_processor::vote_processor (raze::node & node_a) :
-node (node_a)
+node (node_a),
+processing (0),
+stopped (false)
+{
+	auto count (std::max<unsigned> (1, std::min<unsigned> (4, std::thread::hardware_concurrency ())));
+	for (auto i (0u); i < count; ++i)
+	{
+		threads.push_back (std::thread ([this]() { process_loop (); }));
+	}
+}
+
+raze::vote_processor::~vote_processor ()
+{
+	stop ();
+}
+
+bool raze::vote_processor::add (std::shared_ptr<raze::vote> vote_a, raze::endpoint const & endpoint_a)
 {
+	size_t size;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		size = votes.size ();
+	}
+	auto result (false);
+	if (size >= max_votes / 4)
+	{
+		// Past a quarter full votes from accounts without weight are shed, past half full only representatives holding 0.1% of the supply are kept
+		raze::uint128_t weight;
+		{
+			raze::transaction transaction (node.store.environment, nullptr, false);
+			weight = node.ledger.weight (transaction, vote_a->account);
+		}
+		result = size >= max_votes / 2 ? weight < raze::genesis_amount / 1000 : weight == 0;
+	}
+	if (!result)
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		if (votes.size () < max_votes)
+		{
+			votes.push_back (std::make_pair (vote_a, endpoint_a));
+			condition.notify_all ();
+		}
+		else
+		{
+			result = true;
+		}
+	}
+	return result;
 }
 
 raze::vote_result raze::vote_processor::vote (std::shared_ptr<raze::vote> vote_a, raze::endpoint endpoint_a)
@@ -1031,10 +1285,70 @@ raze::vote_result raze::vote_processor::vote (std::shared_ptr<raze::vote> vote_a
 		raze::transaction transaction (node.store.environment, nullptr, false);
 		result = node.store.vote_validate (transaction, vote_a);
 	}
+	apply (vote_a, result, endpoint_a);
+	return result;
+}
+
+void raze::vote_processor::verify_votes (std::deque<std::pair<std::shared_ptr<raze::vote>, raze::endpoint>> & votes_a)
+{
+	auto size (votes_a.size ());
+	std::vector<raze::uint256_union> hashes;
+	hashes.reserve (size);
+	std::vector<unsigned char const *> messages;
+	std::vector<unsigned char const *> pub_keys;
+	std::vector<unsigned char const *> signatures;
+	std::vector<size_t> lengths (size, sizeof (raze::uint256_union));
+	std::vector<int> verifications (size, 0);
+	for (auto i (votes_a.begin ()), n (votes_a.end ()); i != n; ++i)
+	{
+		hashes.push_back (i->first->hash ());
+		messages.push_back (hashes.back ().bytes.data ());
+		pub_keys.push_back (i->first->account.bytes.data ());
+		signatures.push_back (i->first->signature.bytes.data ());
+	}
+	raze::validate_message_batch (messages.data (), lengths.data (), pub_keys.data (), signatures.data (), size, verifications.data ());
+	std::vector<raze::vote_result> results;
+	results.reserve (size);
+	{
+		raze::transaction transaction (node.store.environment, nullptr, false);
+		for (size_t i (0); i < size; ++i)
+		{
+			if (verifications[i] == 1)
+			{
+				node.recent_votes.add (votes_a[i].first);
+				results.push_back (node.store.vote_validate_sequence (transaction, votes_a[i].first));
+			}
+			else
+			{
+				results.push_back (raze::vote_result ({ raze::vote_code::invalid, 0 }));
+			}
+		}
+	}
+	for (size_t i (0); i < size; ++i)
+	{
+		auto & vote_l (votes_a[i].first);
+		auto & result_l (results[i]);
+		apply (vote_l, result_l, votes_a[i].second);
+		if (result_l.code == raze::vote_code::replay)
+		{
+			assert (result_l.vote->sequence > vote_l->sequence);
+			// This tries to assist rep nodes that have lost track of their highest sequence number by replaying our highest known vote back to them
+			// Only do this if the sequence number is significantly different to account for network reordering
+			// Amplify attack considerations: We're sending out a confirm_ack in response to a confirm_ack for no net traffic increase
+			if (result_l.vote->sequence - vote_l->sequence > 10000)
+			{
+				node.network.vote_send (result_l.vote, std::vector<raze::endpoint> (1, votes_a[i].second));
+			}
+		}
+	}
+}
+
+void raze::vote_processor::apply (std::shared_ptr<raze::vote> vote_a, raze::vote_result const & result_a, raze::endpoint const & endpoint_a)
+{
 	if (node.config.logging.vote_logging ())
 	{
 		char const * status;
-		switch (result.code)
+		switch (result_a.code)
 		{
 			case raze::vote_code::invalid:
 				status = "Invalid";
@@ -1043,53 +1357,637 @@ raze::vote_result raze::vote_processor::vote (std::shared_ptr<raze::vote> vote_a
 				status = "Replay";
 				break;
 			case raze::vote_code::vote:
-			case raze::vote_code::vote2:
 				status = "Vote";
 				break;
 		}
-		BOOST_LOG (node.log) << boost::str (boost::format ("Vote from: %1% sequence: %2% block: %3% status: %4%") % vote_a->account.to_account () % std::to_string (vote_a->sequence) % vote_a->block->hash ().to_string () % status);
+		BOOST_LOG (node.log) << boost::str (boost::format ("Vote from: %1% sequence: %2% block: %3% status: %4%") % vote_a->account.to_account () % std::to_string (vote_a->sequence) % vote_target (*vote_a) % status);
 	}
-	switch (result.code)
+	switch (result_a.code)
 	{
 		case raze::vote_code::vote:
-		case raze::vote_code::vote2:
-			node.observers.vote (vote_a, result.code, endpoint_a);
+			observe (vote_a, result_a.code, endpoint_a);
 		case raze::vote_code::replay:
 		case raze::vote_code::invalid:
 			break;
 	}
-	return result;
 }
 
-void raze::rep_crawler::add (raze::block_hash const & hash_a)
+void raze::vote_processor::observe (std::shared_ptr<raze::vote> vote_a, raze::vote_code code_a, raze::endpoint const & endpoint_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	active.insert (hash_a);
+	// Gap blocks aren't in the store so hash votes for them are never split out below
+	node.gap_cache.vote (vote_a);
+	if (vote_a->block != nullptr)
+	{
+		node.observers.vote (vote_a, code_a, endpoint_a);
+	}
+	else
+	{
+		// Each copy keeps the hash list so its signature still verifies, elections don't republish copies
+		std::vector<std::shared_ptr<raze::vote>> votes_l;
+		// Oldest vote among the elections this vote touches, taken before the copies below refresh them
+		boost::optional<std::chrono::steady_clock::time_point> last_vote;
+		{
+			raze::transaction transaction (node.store.environment, nullptr, false);
+			for (auto & i : vote_a->hashes)
+			{
+				auto block (node.store.block_get (transaction, i));
+				if (block != nullptr)
+				{
+					auto vote_l (std::make_shared<raze::vote> (*vote_a));
+					vote_l->block = block;
+					votes_l.push_back (vote_l);
+					auto last_vote_l (node.active.last_vote (*block));
+					if (last_vote_l && (!last_vote || *last_vote_l < *last_vote))
+					{
+						last_vote = last_vote_l;
+					}
+				}
+			}
+		}
+		for (auto & i : votes_l)
+		{
+			node.observers.vote (i, code_a, endpoint_a);
+		}
+		if (last_vote)
+		{
+			node.network.republish_vote (*last_vote, vote_a);
+		}
+	}
 }
 
-void raze::rep_crawler::remove (raze::block_hash const & hash_a)
+void raze::vote_processor::process_loop ()
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	active.erase (hash_a);
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		if (!votes.empty ())
+		{
+			std::deque<std::pair<std::shared_ptr<raze::vote>, raze::endpoint>> votes_l;
+			while (!votes.empty () && votes_l.size () < batch_max)
+			{
+				votes_l.push_back (votes.front ());
+				votes.pop_front ();
+			}
+			++processing;
+			lock.unlock ();
+			verify_votes (votes_l);
+			lock.lock ();
+			--processing;
+			condition.notify_all ();
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
 }
 
-bool raze::rep_crawler::exists (raze::block_hash const & hash_a)
+void raze::vote_processor::flush ()
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	return active.count (hash_a) != 0;
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped && (!votes.empty () || processing != 0))
+	{
+		condition.wait (lock);
+	}
 }
 
-raze::block_processor_item::block_processor_item (std::shared_ptr<raze::block> block_a) :
-block_processor_item (block_a, false)
+void raze::vote_processor::stop ()
 {
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		condition.notify_all ();
+	}
+	for (auto & i : threads)
+	{
+		if (i.joinable ())
+		{
+			i.join ();
+		}
+	}
 }
 
-raze::block_processor_item::block_processor_item (std::shared_ptr<raze::block> block_a, bool force_a) :
-block (block_a),
-force (force_a)
+std::chrono::milliseconds constexpr raze::vote_generator::wait;
+size_t constexpr raze::vote_generator::queue_max;
+
+raze::vote_generator::vote_generator (raze::node & node_a) :
+node (node_a),
+stopped (false),
+thread ([this]() { run (); })
 {
 }
 
+raze::vote_generator::~vote_generator ()
+{
+	stop ();
+}
+
+void raze::vote_generator::add (raze::block_hash const & hash_a, std::vector<raze::endpoint> const & endpoints_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	if (hashes.size () < queue_max)
+	{
+		hashes.push_back (std::make_pair (hash_a, endpoints_a));
+		condition.notify_all ();
+	}
+}
+
+void raze::vote_generator::run ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		if (!hashes.empty ())
+		{
+			// Give other requests a moment to arrive so they can share the signature
+			condition.wait_for (lock, wait, [this]() { return stopped || hashes.size () >= raze::vote::max_hashes; });
+			send (lock);
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+}
+
+void raze::vote_generator::send (std::unique_lock<std::mutex> & lock_a)
+{
+	std::vector<raze::block_hash> hashes_l;
+	std::unordered_set<raze::endpoint> endpoints;
+	while (!hashes.empty () && hashes_l.size () < raze::vote::max_hashes)
+	{
+		auto & front (hashes.front ());
+		if (std::find (hashes_l.begin (), hashes_l.end (), front.first) == hashes_l.end ())
+		{
+			hashes_l.push_back (front.first);
+		}
+		endpoints.insert (front.second.begin (), front.second.end ());
+		hashes.pop_front ();
+	}
+	lock_a.unlock ();
+	std::vector<raze::endpoint> endpoints_l (endpoints.begin (), endpoints.end ());
+	{
+		raze::transaction transaction (node.store.environment, nullptr, false);
+		node.wallets.foreach_representative (transaction, [this, &hashes_l, &endpoints_l, &transaction](raze::public_key const & pub_a, raze::raw_key const & prv_a) {
+			auto vote (this->node.store.vote_generate (transaction, pub_a, prv_a, hashes_l));
+			this->node.network.vote_send (vote, endpoints_l);
+		});
+	}
+	lock_a.lock ();
+}
+
+void raze::vote_generator::stop ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		condition.notify_all ();
+	}
+	if (thread.joinable ())
+	{
+		thread.join ();
+	}
+}
+
+size_t constexpr raze::block_processor::batch_max;
+size_t constexpr raze::confirmation_height_processor::batch_max;
+size_t constexpr raze::confirmation_height_processor::queue_max;
+size_t constexpr raze::confirmation_height_processor::blocks_max;
+
+raze::confirmation_height_processor::confirmation_height_processor (raze::node & node_a) :
+node (node_a),
+stopped (false),
+thread ([this]() { run (); })
+{
+}
+
+raze::confirmation_height_processor::~confirmation_height_processor ()
+{
+	stop ();
+}
+
+void raze::confirmation_height_processor::add (raze::block_hash const & hash_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	if (hashes.size () < queue_max)
+	{
+		hashes.push_back (hash_a);
+		condition.notify_all ();
+	}
+}
+
+void raze::confirmation_height_processor::run ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	auto unfinished (false);
+	while (!stopped)
+	{
+		if (unfinished || !hashes.empty ())
+		{
+			// New confirmations are only taken once the previous walk is done so the walk state stays bounded
+			while (!unfinished && !hashes.empty () && pending.size () < batch_max)
+			{
+				pending.push_back (hashes.front ());
+				hashes.pop_front ();
+			}
+			lock.unlock ();
+			{
+				raze::scheduled_transaction transaction (node.write_scheduler, raze::write_priority::bulk);
+				unfinished = process (transaction);
+			}
+			lock.lock ();
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+}
+
+bool raze::confirmation_height_processor::process (MDB_txn * transaction_a)
+{
+	size_t blocks (0);
+	while (blocks < blocks_max && (!ranges.empty () || !pending.empty ()))
+	{
+		++blocks;
+		if (!ranges.empty ())
+		{
+			auto & range (ranges.back ());
+			if (range.next > range.top)
+			{
+				// Every source below top is confirmed. The range may outlive a rollback between transactions, so only raise to a block still in the ledger
+				auto confirmed (node.store.confirmation_height_get (transaction_a, range.account));
+				if (range.top > confirmed && !node.store.block_at_height (transaction_a, range.account, range.top).is_zero ())
+				{
+					node.store.confirmation_height_put (transaction_a, range.account, range.top);
+				}
+				ranges.pop_back ();
+			}
+			else
+			{
+				// Read uncached, a walk over old history would otherwise flush the hot blocks out of the cache
+				raze::block_type type;
+				auto value (node.store.block_get_raw (transaction_a, node.store.block_at_height (transaction_a, range.account, range.next), type));
+				++range.next;
+				if (value.mv_size != 0)
+				{
+					raze::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data), value.mv_size);
+					auto block (raze::deserialize_block (stream, type));
+					assert (block != nullptr);
+					auto source (block->source ());
+					if (!source.is_zero ())
+					{
+						// The source's account is walked on top of this range, which resumes once it's confirmed
+						walk (transaction_a, source);
+					}
+				}
+			}
+		}
+		else
+		{
+			auto current (pending.back ());
+			pending.pop_back ();
+			walk (transaction_a, current);
+		}
+	}
+	return !ranges.empty () || !pending.empty ();
+}
+
+void raze::confirmation_height_processor::walk (MDB_txn * transaction_a, raze::block_hash const & hash_a)
+{
+	uint64_t height;
+	// A fork winner may not have replaced the ledger block yet, a later confirmation covers it
+	if (!node.store.block_height_get (transaction_a, hash_a, height))
+	{
+		auto account (node.ledger.account (transaction_a, hash_a));
+		auto confirmed (node.store.confirmation_height_get (transaction_a, account));
+		if (height > confirmed)
+		{
+			// An account already being walked further down the stack has every source confirmed below the block it's waiting on
+			auto next (confirmed + 1);
+			for (auto & i : ranges)
+			{
+				if (i.account == account)
+				{
+					next = std::max (next, i.next - 1);
+				}
+			}
+			ranges.push_back (raze::confirmation_range{ account, next, height });
+		}
+	}
+}
+
+void raze::confirmation_height_processor::stop ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		condition.notify_all ();
+	}
+	if (thread.joinable ())
+	{
+		thread.join ();
+	}
+}
+
+void raze::rep_crawler::add (raze::block_hash const & hash_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	active.insert (hash_a);
+}
+
+void raze::rep_crawler::remove (raze::block_hash const & hash_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	active.erase (hash_a);
+}
+
+bool raze::rep_crawler::exists (raze::block_hash const & hash_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return active.count (hash_a) != 0;
+}
+
+raze::block_processor_item::block_processor_item (std::shared_ptr<raze::block> block_a) :
+block_processor_item (block_a, false)
+{
+}
+
+raze::block_processor_item::block_processor_item (std::shared_ptr<raze::block> block_a, bool force_a) :
+block (block_a),
+force (force_a)
+{
+}
+
+raze::write_ticket::write_ticket (raze::write_scheduler & scheduler_a, raze::write_priority priority_a) :
+scheduler (scheduler_a)
+{
+	scheduler.acquire (priority_a);
+}
+
+raze::write_ticket::~write_ticket ()
+{
+	scheduler.release ();
+}
+
+raze::scheduled_transaction::scheduled_transaction (raze::write_scheduler & scheduler_a, raze::write_priority priority_a) :
+write_ticket (scheduler_a, priority_a),
+transaction (scheduler_a.environment, nullptr, true)
+{
+}
+
+raze::write_scheduler_stats::write_scheduler_stats () :
+waiting (0),
+queued (0),
+granted (0),
+wait_total (0),
+wait_max (0)
+{
+}
+
+size_t constexpr raze::write_scheduler::batch_max;
+
+raze::write_scheduler::write_scheduler (raze::mdb_env & environment_a) :
+environment (environment_a),
+held (false),
+stopped (false),
+thread ([this]() { run (); })
+{
+}
+
+raze::write_scheduler::~write_scheduler ()
+{
+	stop ();
+}
+
+void raze::write_scheduler::add (raze::write_priority priority_a, std::function<void(MDB_txn *)> const & action_a)
+{
+	auto index (static_cast<size_t> (priority_a));
+	std::lock_guard<std::mutex> lock (mutex);
+	actions[index].push_back (action_a);
+	++counters[index].queued;
+	condition.notify_all ();
+}
+
+bool raze::write_scheduler::contended (raze::write_priority priority_a)
+{
+	auto index (static_cast<size_t> (priority_a));
+	auto result (false);
+	std::lock_guard<std::mutex> lock (mutex);
+	for (size_t i (0); !result && i < index; ++i)
+	{
+		result = counters[i].waiting > 0;
+	}
+	return result;
+}
+
+std::array<raze::write_scheduler_stats, 3> raze::write_scheduler::stats ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return counters;
+}
+
+void raze::write_scheduler::acquire (raze::write_priority priority_a)
+{
+	auto index (static_cast<size_t> (priority_a));
+	auto start (std::chrono::steady_clock::now ());
+	std::unique_lock<std::mutex> lock (mutex);
+	assert (!held || owner != std::this_thread::get_id ());
+	++counters[index].waiting;
+	auto blocked ([this, index]() {
+		auto result (held);
+		for (size_t i (0); !result && i < index; ++i)
+		{
+			result = counters[i].waiting > 0;
+		}
+		return result;
+	});
+	while (blocked ())
+	{
+		condition.wait (lock);
+	}
+	held = true;
+	owner = std::this_thread::get_id ();
+	auto & counters_l (counters[index]);
+	--counters_l.waiting;
+	++counters_l.granted;
+	auto wait (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - start));
+	counters_l.wait_total += wait;
+	counters_l.wait_max = std::max (counters_l.wait_max, wait);
+}
+
+void raze::write_scheduler::release ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	assert (held);
+	assert (owner == std::this_thread::get_id ());
+	held = false;
+	owner = std::thread::id ();
+	condition.notify_all ();
+}
+
+void raze::write_scheduler::run ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	auto done (false);
+	while (!done)
+	{
+		auto first (std::find_if (actions.begin (), actions.end (), [](std::deque<std::function<void(MDB_txn *)>> const & actions_a) { return !actions_a.empty (); }));
+		if (first != actions.end ())
+		{
+			auto priority (static_cast<raze::write_priority> (first - actions.begin ()));
+			lock.unlock ();
+			{
+				raze::scheduled_transaction transaction (*this, priority);
+				// Everything queued by the time we get the turn shares the transaction, highest priority first
+				std::vector<std::function<void(MDB_txn *)>> batch;
+				{
+					std::lock_guard<std::mutex> batch_lock (mutex);
+					for (size_t i (0), n (actions.size ()); i < n && batch.size () < batch_max; ++i)
+					{
+						auto & queue (actions[i]);
+						while (!queue.empty () && batch.size () < batch_max)
+						{
+							batch.push_back (std::move (queue.front ()));
+							queue.pop_front ();
+							--counters[i].queued;
+						}
+					}
+				}
+				for (auto & i : batch)
+				{
+					i (transaction);
+				}
+			}
+			lock.lock ();
+		}
+		else if (stopped)
+		{
+			done = true;
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+}
+
+void raze::write_scheduler::stop ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		condition.notify_all ();
+	}
+	if (thread.joinable ())
+	{
+		thread.join ();
+	}
+}
+
+std::chrono::milliseconds constexpr raze::ledger_journal::persist_interval;
+
+raze::ledger_journal::ledger_journal (bool & error_a, boost::filesystem::path const & path_a) :
+environment (error_a, path_a),
+entries (0),
+added (0),
+sequence (0)
+{
+	if (!error_a)
+	{
+		raze::transaction transaction (environment, nullptr, true);
+		error_a |= mdb_dbi_open (transaction, "entries", MDB_CREATE | MDB_INTEGERKEY, &entries) != 0;
+		if (!error_a)
+		{
+			for (raze::store_iterator i (transaction, entries), n (nullptr); i != n; ++i)
+			{
+				assert (i->first.size () == sizeof (sequence));
+				std::copy (reinterpret_cast<uint8_t const *> (i->first.data ()), reinterpret_cast<uint8_t const *> (i->first.data ()) + sizeof (sequence), reinterpret_cast<uint8_t *> (&sequence));
+			}
+			added = sequence;
+		}
+	}
+}
+
+void raze::ledger_journal::add (raze::block const & block_a, bool force_a)
+{
+	std::vector<uint8_t> vector;
+	{
+		raze::vectorstream stream (vector);
+		raze::serialize_block (stream, block_a);
+		uint8_t force (force_a ? 1 : 0);
+		raze::write (stream, force);
+	}
+	std::lock_guard<std::mutex> lock (mutex);
+	pending.push_back (std::move (vector));
+	++added;
+}
+
+uint64_t raze::ledger_journal::last_added ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return added;
+}
+
+uint64_t raze::ledger_journal::persist ()
+{
+	std::lock_guard<std::mutex> persist_lock (persist_mutex);
+	std::vector<std::vector<uint8_t>> pending_l;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		pending_l.swap (pending);
+	}
+	if (!pending_l.empty ())
+	{
+		raze::transaction transaction (environment, nullptr, true);
+		for (auto & i : pending_l)
+		{
+			++sequence;
+			auto status (mdb_put (transaction, entries, raze::mdb_val (sizeof (sequence), &sequence), raze::mdb_val (i.size (), i.data ()), MDB_APPEND));
+			assert (status == 0);
+		}
+	}
+	return sequence;
+}
+
+void raze::ledger_journal::erase (uint64_t sequence_a)
+{
+	raze::transaction transaction (environment, nullptr, true);
+	for (raze::store_iterator i (transaction, entries), n (nullptr); i != n;)
+	{
+		uint64_t sequence_l;
+		std::copy (reinterpret_cast<uint8_t const *> (i->first.data ()), reinterpret_cast<uint8_t const *> (i->first.data ()) + sizeof (sequence_l), reinterpret_cast<uint8_t *> (&sequence_l));
+		if (sequence_l <= sequence_a)
+		{
+			auto status (mdb_cursor_del (i.cursor, 0));
+			assert (status == 0);
+			// Stepping after a delete lands on the entry that followed the deleted one
+			++i;
+		}
+		else
+		{
+			i = raze::store_iterator (nullptr);
+		}
+	}
+}
+
+std::deque<raze::block_processor_item> raze::ledger_journal::blocks ()
+{
+	std::deque<raze::block_processor_item> result;
+	raze::transaction transaction (environment, nullptr, false);
+	for (raze::store_iterator i (transaction, entries), n (nullptr); i != n; ++i)
+	{
+		raze::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
+		std::shared_ptr<raze::block> block (raze::deserialize_block (stream));
+		assert (block != nullptr);
+		// Entries written before the force byte was added have none
+		uint8_t force (0);
+		raze::read (stream, force);
+		result.push_back (raze::block_processor_item (block, force != 0));
+	}
+	return result;
+}
+
 raze::block_processor::block_processor (raze::node & node_a) :
 stopped (false),
 idle (true),
@@ -1159,22 +2057,42 @@ void raze::block_processor::process_receive_many (raze::block_processor_item con
 
 void raze::block_processor::process_receive_many (std::deque<raze::block_processor_item> & blocks_processing)
 {
+	{
+		// Bulk sources deliver chains out of order, put in-batch dependencies first so they don't round trip through unchecked
+		std::vector<std::shared_ptr<raze::block>> blocks_l;
+		blocks_l.reserve (blocks_processing.size ());
+		for (auto & i : blocks_processing)
+		{
+			blocks_l.push_back (i.block);
+		}
+		std::deque<raze::block_processor_item> ordered;
+		for (auto i : raze::ledger::dependency_order (blocks_l))
+		{
+			ordered.push_back (blocks_processing[i]);
+		}
+		blocks_processing.swap (ordered);
+	}
 	while (!blocks_processing.empty ())
 	{
 		std::deque<std::pair<std::shared_ptr<raze::block>, raze::process_return>> progress;
 		{
-			raze::transaction transaction (node.store.environment, nullptr, true);
+			raze::scheduled_transaction transaction (node.write_scheduler, raze::write_priority::bulk);
+			raze::store_write_buffer buffer (node.store, transaction);
 			auto cutoff (std::chrono::steady_clock::now () + raze::transaction_timeout);
-			while (!blocks_processing.empty () && std::chrono::steady_clock::now () < cutoff)
+			// Give up the turn early when votes or elections are waiting to write
+			while (!blocks_processing.empty () && std::chrono::steady_clock::now () < cutoff && !node.write_scheduler.contended (raze::write_priority::bulk))
 			{
-				auto item (blocks_processing.front ());
-				blocks_processing.pop_front ();
-				auto hash2_new (node.store.hash2_calc (transaction, *item.block));
-				if (item.force)
+				// A forced block replaces a fork before it's processed so it goes through on its own, runs of the rest share a ledger batch
+				std::vector<raze::block_processor_item> items;
+				if (blocks_processing.front ().force)
 				{
-					auto successor (node.ledger.successor (transaction, item.block->root ()));
+					items.push_back (blocks_processing.front ());
+					blocks_processing.pop_front ();
+					auto & block (*items.front ().block);
+					auto successor (node.ledger.successor (transaction, block.root ()));
 					if (successor != nullptr)
 					{
+						auto hash2_new (node.store.hash2_calc (transaction, block));
 						auto hash2_existing (node.store.hash2_calc (transaction, *successor));
 						if (hash2_new != hash2_existing)
 						{
@@ -1184,28 +2102,47 @@ void raze::block_processor::process_receive_many (std::deque<raze::block_process
 						}
 					}
 				}
-				auto hash (item.block->hash ());
-				auto process_result (process_receive_one (transaction, item.block));
-				switch (process_result.code)
+				else
 				{
-					case raze::process_result::progress:
+					while (!blocks_processing.empty () && !blocks_processing.front ().force && items.size () < batch_max)
 					{
-						progress.push_back (std::make_pair (item.block, process_result));
+						items.push_back (blocks_processing.front ());
+						blocks_processing.pop_front ();
 					}
-					case raze::process_result::old:
+				}
+				std::vector<std::shared_ptr<raze::block>> blocks_l;
+				blocks_l.reserve (items.size ());
+				for (auto & i : items)
+				{
+					blocks_l.push_back (i.block);
+				}
+				auto results (node.ledger.process_batch (transaction, blocks_l));
+				for (size_t i (0), n (items.size ()); i < n; ++i)
+				{
+					auto & item (items[i]);
+					auto & result (results[i]);
+					process_result (transaction, item.block, result, item.force);
+					switch (result.code)
 					{
-						auto cached (node.store.unchecked_get (transaction, hash));
-						for (auto i (cached.begin ()), n (cached.end ()); i != n; ++i)
+						case raze::process_result::progress:
+						{
+							progress.push_back (std::make_pair (item.block, result));
+						}
+						case raze::process_result::old:
 						{
-							node.store.unchecked_del (transaction, hash, **i);
-							blocks_processing.push_front (raze::block_processor_item (*i));
+							auto hash (item.block->hash ());
+							auto cached (node.store.unchecked_get (transaction, hash));
+							for (auto j (cached.begin ()), m (cached.end ()); j != m; ++j)
+							{
+								node.store.unchecked_del (transaction, hash, **j);
+								blocks_processing.push_front (raze::block_processor_item (*j));
+							}
+							node.gap_cache.erase (hash);
+							break;
 						}
-						std::lock_guard<std::mutex> lock (node.gap_cache.mutex);
-						node.gap_cache.blocks.get<1> ().erase (hash);
-						break;
+						default:
+							break;
 					}
-					default:
-						break;
 				}
 			}
 		}
@@ -1224,14 +2161,23 @@ void raze::block_processor::process_receive_many (std::deque<raze::block_process
 	}
 }
 
-raze::process_return raze::block_processor::process_receive_one (MDB_txn * transaction_a, std::shared_ptr<raze::block> block_a)
+raze::process_return raze::block_processor::process_receive_one (MDB_txn * transaction_a, std::shared_ptr<raze::block> block_a, bool force_a)
 {
-	raze::process_return result;
-	result = node.ledger.process (transaction_a, *block_a);
-	switch (result.code)
+	auto result (node.ledger.process (transaction_a, *block_a));
+	process_result (transaction_a, block_a, result, force_a);
+	return result;
+}
+
+void raze::block_processor::process_result (MDB_txn * transaction_a, std::shared_ptr<raze::block> block_a, raze::process_return const & result_a, bool force_a)
+{
+	switch (result_a.code)
 	{
 		case raze::process_result::progress:
 		{
+			if (node.journal != nullptr)
+			{
+				node.journal->add (*block_a, force_a);
+			}
 			if (node.config.logging.ledger_logging ())
 			{
 				std::string block;
@@ -1347,7 +2293,6 @@ raze::process_return raze::block_processor::process_receive_one (MDB_txn * trans
 			BOOST_LOG (node.log) << boost::str (boost::format ("*** Rejecting open block for burn account ***: %1%") % block_a->hash ().to_string ());
 		}
 	}
-	return result;
 }
 
 raze::node::node (raze::node_init & init_a, boost::asio::io_service & service_a, uint16_t peering_port_a, boost::filesystem::path const & application_path_a, raze::alarm & alarm_a, raze::logging const & logging_a, raze::work_pool & work_a) :
@@ -1360,18 +2305,21 @@ service (service_a),
 config (config_a),
 alarm (alarm_a),
 work (work_a),
-store (init_a.block_store_init, application_path_a / "data.ldb", config_a.lmdb_max_dbs),
+store (init_a.block_store_init, application_path_a / "data.ldb", config_a.lmdb_max_dbs, config_a.read_only),
+write_scheduler (store.environment),
 gap_cache (*this),
 ledger (store, config_a.inactive_supply.number ()),
 active (*this),
-wallets (init_a.block_store_init, *this),
-network (*this, config.peering_port),
+wallets (init_a, *this, application_path_a / "wallets.ldb"),
+network (*this, config.read_only ? 0 : config.peering_port),
 bootstrap_initiator (*this),
 bootstrap (service_a, config.peering_port, *this),
 peers (network.endpoint ()),
 application_path (application_path_a),
 port_mapping (*this),
 vote_processor (*this),
+vote_generator (*this),
+confirmation_height_processor (*this),
 warmed_up (0),
 block_processor (*this),
 block_processor_thread ([this]() { this->block_processor.process_blocks (); })
@@ -1388,8 +2336,9 @@ block_processor_thread ([this]() { this->block_processor.process_blocks (); })
 	observers.blocks.add ([this](std::shared_ptr<raze::block> block_a, raze::account const & account_a, raze::amount const & amount_a) {
 		if (this->block_arrival.recent (block_a->hash ()))
 		{
-			raze::transaction transaction (store.environment, nullptr, true);
-			active.start (transaction, block_a);
+			write_scheduler.add (raze::write_priority::consensus, [this, block_a](MDB_txn * transaction_a) {
+				active.start (transaction_a, block_a);
+			});
 		}
 	});
 	observers.blocks.add ([this](std::shared_ptr<raze::block> block_a, raze::account const & account_a, raze::amount const & amount_a) {
@@ -1497,14 +2446,8 @@ block_processor_thread ([this]() { this->block_processor.process_blocks (); })
 		rep_query (*this, endpoint_a);
 	});
 	observers.vote.add ([this](std::shared_ptr<raze::vote> vote_a, raze::vote_code code, raze::endpoint const & endpoint_a) {
-		assert (code == raze::vote_code::vote || code == raze::vote_code::vote2);
-		if (!peers.hash2_aware (endpoint_a) || code == raze::vote_code::vote2)
-		{
-			active.vote (vote_a);
-		}
-	});
-	observers.vote.add ([this](std::shared_ptr<raze::vote> vote_a, raze::vote_code, raze::endpoint const &) {
-		this->gap_cache.vote (vote_a);
+		assert (code == raze::vote_code::vote);
+		active.vote (vote_a);
 	});
 	observers.vote.add ([this](std::shared_ptr<raze::vote> vote_a, raze::vote_code, raze::endpoint const & endpoint_a) {
 		if (this->rep_crawler.exists (vote_a->block->hash ()))
@@ -1525,6 +2468,19 @@ block_processor_thread ([this]() { this->block_processor.process_blocks (); })
 		{
 			BOOST_LOG (log) << "Constructing node";
 		}
+		if (config.lmdb_sync_interval > 0 && !config.read_only)
+		{
+			journal.reset (new raze::ledger_journal (init_a.block_store_init, application_path_a / "journal.ldb"));
+			if (!init_a.block_store_init)
+			{
+				// Commits become visible without waiting on the disk, durability comes from the journal and ledger_sync
+				auto status (mdb_env_set_flags (store.environment, MDB_NOSYNC, 1));
+				assert (status == 0);
+			}
+		}
+	}
+	if (!init_a.error () && !config.read_only)
+	{
 		raze::transaction transaction (store.environment, nullptr, true);
 		if (store.latest_begin (transaction) == store.latest_end ())
 		{
@@ -1533,34 +2489,58 @@ block_processor_thread ([this]() { this->block_processor.process_blocks (); })
 			genesis.initialize (transaction, store);
 		}
 	}
-	if (raze::raze_network == raze::raze_networks::raze_live_network)
+	if (!config.bootstrap_weights_file.empty ())
+	{
+		auto weights_path (boost::filesystem::path (config.bootstrap_weights_file));
+		if (weights_path.is_relative ())
+		{
+			weights_path = application_path_a / weights_path;
+		}
+		std::ifstream weights_file (weights_path.string (), std::ios::binary);
+		if (weights_file.good ())
+		{
+			std::vector<uint8_t> weights ((std::istreambuf_iterator<char> (weights_file)), std::istreambuf_iterator<char> ());
+			raze::bufferstream weight_stream (weights.data (), weights.size ());
+			load_bootstrap_weights (weight_stream);
+		}
+		else
+		{
+			BOOST_LOG (log) << boost::str (boost::format ("Unable to read bootstrap weights file %1%") % weights_path.string ());
+		}
+	}
+	else if (raze::raze_network == raze::raze_networks::raze_live_network)
 	{
 		extern const char raze_bootstrap_weights[];
 		extern const size_t raze_bootstrap_weights_size;
 		raze::bufferstream weight_stream ((const uint8_t *)raze_bootstrap_weights, raze_bootstrap_weights_size);
-		raze::uint128_union block_height;
-		if (!raze::read (weight_stream, block_height))
+		load_bootstrap_weights (weight_stream);
+	}
+}
+
+void raze::node::load_bootstrap_weights (raze::stream & stream_a)
+{
+	raze::uint128_union block_height;
+	if (!raze::read (stream_a, block_height))
+	{
+		auto max_blocks = (uint64_t)block_height.number ();
+		raze::transaction transaction (store.environment, nullptr, false);
+		if (ledger.store.block_count (transaction).sum () < max_blocks)
 		{
-			auto max_blocks = (uint64_t)block_height.number ();
-			raze::transaction transaction (store.environment, nullptr, false);
-			if (ledger.store.block_count (transaction).sum () < max_blocks)
+			ledger.bootstrap_weight_max_blocks = max_blocks;
+			while (true)
 			{
-				ledger.bootstrap_weight_max_blocks = max_blocks;
-				while (true)
+				raze::account account;
+				if (raze::read (stream_a, account.bytes))
 				{
-					raze::account account;
-					if (raze::read (weight_stream, account.bytes))
-					{
-						break;
-					}
-					raze::amount weight;
-					if (raze::read (weight_stream, weight.bytes))
-					{
-						break;
-					}
-					BOOST_LOG (log) << "Using bootstrap rep weight: " << account.to_account () << " -> " << weight.format_balance (Mraze_ratio, 0, true) << " XRB";
-					ledger.bootstrap_weights[account] = weight.number ();
+					break;
+				}
+				raze::amount weight;
+				if (raze::read (stream_a, weight.bytes))
+				{
+					break;
 				}
+				BOOST_LOG (log) << "Using bootstrap rep weight: " << account.to_account () << " -> " << weight.format_balance (Mraze_ratio, 0, true) << " XRB";
+				ledger.bootstrap_weights[account] = weight.number ();
 			}
 		}
 	}
@@ -1592,57 +2572,108 @@ void raze::node::send_keepalive (raze::endpoint const & endpoint_a)
 	network.send_keepalive (endpoint_l);
 }
 
+std::chrono::milliseconds constexpr raze::gap_cache::bootstrap_interval;
+
 raze::gap_cache::gap_cache (raze::node & node_a) :
+shard_max (std::max<size_t> (node_a.config.gap_cache_max / shard_count, 1)),
 node (node_a)
 {
 }
 
+raze::gap_cache_shard & raze::gap_cache::shard (raze::block_hash const & hash_a)
+{
+	return shards[hash_a.qwords[0] % shard_count];
+}
+
 void raze::gap_cache::add (MDB_txn * transaction_a, std::shared_ptr<raze::block> block_a)
 {
 	auto hash (block_a->hash ());
-	std::lock_guard<std::mutex> lock (mutex);
-	auto existing (blocks.get<1> ().find (hash));
-	if (existing != blocks.get<1> ().end ())
+	auto & shard_l (shard (hash));
+	std::lock_guard<std::mutex> lock (shard_l.mutex);
+	auto existing (shard_l.blocks.get<1> ().find (hash));
+	if (existing != shard_l.blocks.get<1> ().end ())
 	{
-		blocks.get<1> ().modify (existing, [](raze::gap_information & info) {
+		shard_l.blocks.get<1> ().modify (existing, [](raze::gap_information & info) {
 			info.arrival = std::chrono::steady_clock::now ();
 		});
 	}
 	else
 	{
-		blocks.insert ({ std::chrono::steady_clock::now (), hash, std::unique_ptr<raze::votes> (new raze::votes (block_a)) });
-		if (blocks.size () > max)
+		shard_l.blocks.insert ({ std::chrono::steady_clock::now (), hash, std::unordered_set<raze::account> (), 0, false });
+		if (shard_l.blocks.size () > shard_max)
 		{
-			blocks.get<0> ().erase (blocks.get<0> ().begin ());
+			shard_l.blocks.get<0> ().erase (shard_l.blocks.get<0> ().begin ());
 		}
 	}
 }
 
+void raze::gap_cache::erase (raze::block_hash const & hash_a)
+{
+	auto & shard_l (shard (hash_a));
+	std::lock_guard<std::mutex> lock (shard_l.mutex);
+	shard_l.blocks.get<1> ().erase (hash_a);
+}
+
 void raze::gap_cache::vote (std::shared_ptr<raze::vote> vote_a)
 {
-	raze::transaction transaction (node.store.environment, nullptr, false);
-	std::lock_guard<std::mutex> lock (mutex);
-	auto hash (vote_a->block->hash ());
-	auto existing (blocks.get<1> ().find (hash));
-	if (existing != blocks.get<1> ().end ())
-	{
-		existing->votes->vote (vote_a);
-		auto winner (node.ledger.winner (transaction, *existing->votes));
-		if (winner.first > bootstrap_threshold (transaction))
-		{
-			auto node_l (node.shared ());
-			auto now (std::chrono::steady_clock::now ());
-			node.alarm.add (raze::raze_network == raze::raze_networks::raze_test_network ? now + std::chrono::milliseconds (5) : now + std::chrono::seconds (5), [node_l, hash]() {
-				raze::transaction transaction (node_l->store.environment, nullptr, false);
-				if (!node_l->store.block_exists (transaction, hash))
+	std::vector<raze::block_hash> hashes;
+	if (vote_a->block != nullptr)
+	{
+		hashes.push_back (vote_a->block->hash ());
+	}
+	else
+	{
+		hashes = vote_a->hashes;
+	}
+	// Almost every vote is for a block we have, only look up weight for new voters on gap blocks
+	std::vector<raze::block_hash> candidates;
+	for (auto & i : hashes)
+	{
+		auto & shard_l (shard (i));
+		std::lock_guard<std::mutex> lock (shard_l.mutex);
+		auto existing (shard_l.blocks.get<1> ().find (i));
+		if (existing != shard_l.blocks.get<1> ().end () && existing->voters.find (vote_a->account) == existing->voters.end ())
+		{
+			candidates.push_back (i);
+		}
+	}
+	if (!candidates.empty ())
+	{
+		raze::transaction transaction (node.store.environment, nullptr, false);
+		auto weight (node.ledger.weight (transaction, vote_a->account));
+		if (!weight.is_zero ())
+		{
+			auto threshold (bootstrap_threshold (transaction));
+			for (auto & i : candidates)
+			{
+				auto start (false);
 				{
-					if (!node_l->bootstrap_initiator.in_progress ())
+					auto & shard_l (shard (i));
+					std::lock_guard<std::mutex> lock (shard_l.mutex);
+					auto existing (shard_l.blocks.get<1> ().find (i));
+					if (existing != shard_l.blocks.get<1> ().end () && existing->voters.find (vote_a->account) == existing->voters.end ())
 					{
-						BOOST_LOG (node_l->log) << boost::str (boost::format ("Missing confirmed block %1%") % hash.to_string ());
+						shard_l.blocks.get<1> ().modify (existing, [&vote_a, &weight, &threshold, &start](raze::gap_information & info) {
+							info.voters.insert (vote_a->account);
+							info.weight += weight;
+							if (info.weight > threshold && !info.bootstrap_started)
+							{
+								info.bootstrap_started = true;
+								start = true;
+							}
+						});
 					}
-					node_l->bootstrap_initiator.bootstrap ();
 				}
-			});
+				if (start)
+				{
+					auto node_l (node.shared ());
+					auto now (std::chrono::steady_clock::now ());
+					auto hash (i);
+					node.alarm.add (raze::raze_network == raze::raze_networks::raze_test_network ? now + std::chrono::milliseconds (5) : now + std::chrono::seconds (5), [node_l, hash]() {
+						node_l->gap_cache.bootstrap_check (hash);
+					});
+				}
+			}
 		}
 	}
 }
@@ -1653,30 +2684,100 @@ raze::uint128_t raze::gap_cache::bootstrap_threshold (MDB_txn * transaction_a)
 	return result;
 }
 
+void raze::gap_cache::bootstrap_check (raze::block_hash const & hash_a)
+{
+	raze::transaction transaction (node.store.environment, nullptr, false);
+	if (!node.store.block_exists (transaction, hash_a))
+	{
+		auto now (std::chrono::steady_clock::now ());
+		auto skipped (false);
+		{
+			std::lock_guard<std::mutex> lock (bootstrap_mutex);
+			// Votes for many gap blocks cross the threshold together, one attempt finds all of them
+			if (!node.bootstrap_initiator.in_progress () && bootstrap_last + bootstrap_interval <= now)
+			{
+				bootstrap_last = now;
+				BOOST_LOG (node.log) << boost::str (boost::format ("Missing confirmed block %1%") % hash_a.to_string ());
+				node.bootstrap_initiator.bootstrap ();
+			}
+			else
+			{
+				skipped = true;
+			}
+		}
+		if (skipped)
+		{
+			// The block's votes won't start another check, retry until it arrives or leaves the cache
+			auto cached (false);
+			{
+				auto & shard_l (shard (hash_a));
+				std::lock_guard<std::mutex> lock (shard_l.mutex);
+				cached = shard_l.blocks.get<1> ().find (hash_a) != shard_l.blocks.get<1> ().end ();
+			}
+			if (cached)
+			{
+				auto node_l (node.shared ());
+				auto hash (hash_a);
+				node.alarm.add (now + bootstrap_interval, [node_l, hash]() {
+					node_l->gap_cache.bootstrap_check (hash);
+				});
+			}
+		}
+	}
+}
+
 void raze::gap_cache::purge_old ()
 {
-	auto cutoff (std::chrono::steady_clock::now () - std::chrono::seconds (10));
-	std::lock_guard<std::mutex> lock (mutex);
-	auto done (false);
-	while (!done && !blocks.empty ())
+	auto cutoff (std::chrono::steady_clock::now () - std::chrono::seconds (node.config.gap_cache_purge_age));
+	for (auto & i : shards)
 	{
-		auto first (blocks.get<1> ().begin ());
-		if (first->arrival < cutoff)
+		std::lock_guard<std::mutex> lock (i.mutex);
+		auto done (false);
+		while (!done && !i.blocks.empty ())
 		{
-			blocks.get<1> ().erase (first);
+			auto first (i.blocks.get<0> ().begin ());
+			if (first->arrival < cutoff)
+			{
+				i.blocks.get<0> ().erase (first);
+			}
+			else
+			{
+				done = true;
+			}
 		}
-		else
+	}
+}
+
+void raze::network::vote_send (std::shared_ptr<raze::vote> vote_a, std::vector<raze::endpoint> const & endpoints_a)
+{
+	std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
+	if (vote_a->hashes.empty ())
+	{
+		raze::confirm_ack confirm (vote_a);
+		raze::vectorstream stream (*bytes);
+		confirm.serialize (stream);
+	}
+	else
+	{
+		raze::confirm_ack_hashes confirm (vote_a);
+		raze::vectorstream stream (*bytes);
+		confirm.serialize (stream);
+	}
+	for (auto i (endpoints_a.begin ()), n (endpoints_a.end ()); i != n; ++i)
+	{
+		// Older peers can't check a signature over several hashes
+		if (vote_a->hashes.empty () || node.peers.vote_by_hash_aware (*i))
 		{
-			done = true;
+			confirm_send (vote_a, bytes, *i);
 		}
 	}
 }
 
-void raze::network::confirm_send (raze::confirm_ack const & confirm_a, std::shared_ptr<std::vector<uint8_t>> bytes_a, raze::endpoint const & endpoint_a)
+void raze::network::confirm_send (std::shared_ptr<raze::vote> vote_a, std::shared_ptr<std::vector<uint8_t>> bytes_a, raze::endpoint const & endpoint_a)
 {
 	if (node.config.logging.network_publish_logging ())
 	{
-		BOOST_LOG (node.log) << boost::str (boost::format ("Sending confirm_ack for block %1% to %2% sequence %3%") % confirm_a.vote->block->hash ().to_string () % endpoint_a % std::to_string (confirm_a.vote->sequence));
+		BOOST_LOG (node.log) << boost::str (boost::format ("Sending confirm_ack for block %1% to %2% sequence %3%") % vote_target (*vote_a) % endpoint_a % std::to_string (vote_a->sequence));
 	}
 	std::weak_ptr<raze::node> node_w (node.shared ());
 	++outgoing.confirm_ack;
@@ -1699,8 +2800,12 @@ void raze::node::process_active (std::shared_ptr<raze::block> incoming)
 
 raze::process_return raze::node::process (raze::block const & block_a)
 {
-	raze::transaction transaction (store.environment, nullptr, true);
+	raze::scheduled_transaction transaction (write_scheduler, raze::write_priority::normal);
 	auto result (ledger.process (transaction, block_a));
+	if (result.code == raze::process_result::progress && journal != nullptr)
+	{
+		journal->add (block_a, false);
+	}
 	return result;
 }
 
@@ -1841,20 +2946,52 @@ bool raze::parse_tcp_endpoint (std::string const & string, raze::tcp_endpoint &
 
 void raze::node::start ()
 {
-	if (store_version () < 11)
+	if (config.read_only)
+	{
+		BOOST_LOG (log) << "Node running read only, serving the ledger of another node process";
+	}
+	else
 	{
-		store_update ();
-	}
-	network.receive ();
-	ongoing_keepalive ();
-	ongoing_bootstrap ();
-	ongoing_store_flush ();
-	ongoing_rep_crawl ();
-	bootstrap.start ();
-	backup_wallet ();
-	active.announce_votes ();
-	port_mapping.start ();
-	add_initial_peers ();
+		if (store_version () < 11)
+		{
+			store_update ();
+		}
+		if (journal != nullptr)
+		{
+			auto replay (journal->blocks ());
+			if (!replay.empty ())
+			{
+				BOOST_LOG (log) << boost::str (boost::format ("Replaying %1% journaled blocks") % replay.size ());
+				// Batches are reordered by dependency, a forced replacement has to stay after the blocks it replaced
+				std::deque<raze::block_processor_item> items;
+				for (auto & i : replay)
+				{
+					if (i.force && !items.empty ())
+					{
+						block_processor.process_receive_many (items);
+						items.clear ();
+					}
+					items.push_back (i);
+				}
+				if (!items.empty ())
+				{
+					block_processor.process_receive_many (items);
+				}
+			}
+			ledger_sync ();
+			ongoing_ledger_sync (std::chrono::steady_clock::now ());
+		}
+		network.receive ();
+		ongoing_keepalive ();
+		ongoing_bootstrap ();
+		ongoing_store_flush ();
+		ongoing_rep_crawl ();
+		bootstrap.start ();
+		backup_wallet ();
+		active.announce_votes ();
+		port_mapping.start ();
+		add_initial_peers ();
+	}
 	observers.started ();
 }
 
@@ -1870,11 +3007,15 @@ void raze::node::store_update ()
 void raze::node::stop ()
 {
 	BOOST_LOG (log) << "Node stopping";
+	vote_processor.stop ();
+	vote_generator.stop ();
+	confirmation_height_processor.stop ();
 	block_processor.stop ();
 	if (block_processor_thread.joinable ())
 	{
 		block_processor_thread.join ();
 	}
+	write_scheduler.stop ();
 	active.stop ();
 	network.stop ();
 	bootstrap_initiator.stop ();
@@ -1885,6 +3026,10 @@ void raze::node::stop ()
 	{
 		block_processor_thread.join ();
 	}
+	if (journal != nullptr)
+	{
+		ledger_sync ();
+	}
 }
 
 void raze::node::keepalive_preconfigured (std::vector<std::string> const & peers_a)
@@ -1907,7 +3052,7 @@ raze::uint128_t raze::node::balance (raze::account const & account_a)
 	return ledger.account_balance (transaction, account_a);
 }
 
-std::unique_ptr<raze::block> raze::node::block (raze::block_hash const & hash_a)
+std::shared_ptr<raze::block> raze::node::block (raze::block_hash const & hash_a)
 {
 	raze::transaction transaction (store.environment, nullptr, false);
 	return store.block_get (transaction, hash_a);
@@ -1943,6 +3088,7 @@ raze::account raze::node::representative (raze::account const & account_a)
 void raze::node::ongoing_keepalive ()
 {
 	keepalive_preconfigured (config.preconfigured_peers);
+	gap_cache.purge_old ();
 	auto peers_l (peers.purge_list (std::chrono::steady_clock::now () - cutoff));
 	for (auto i (peers_l.begin ()), j (peers_l.end ()); i != j && std::chrono::steady_clock::now () - i->last_attempt > period; ++i)
 	{
@@ -1996,12 +3142,51 @@ void raze::node::ongoing_bootstrap ()
 	});
 }
 
-void raze::node::ongoing_store_flush ()
+void raze::node::ongoing_ledger_sync (std::chrono::steady_clock::time_point const & last_sync_a)
 {
+	auto last_sync (last_sync_a);
+	journal->persist ();
+	auto now (std::chrono::steady_clock::now ());
+	if (now - last_sync >= std::chrono::milliseconds (config.lmdb_sync_interval))
 	{
-		raze::transaction transaction (store.environment, nullptr, true);
-		store.flush (transaction);
+		ledger_sync ();
+		last_sync = now;
+	}
+	std::weak_ptr<raze::node> node_w (shared_from_this ());
+	alarm.add (now + raze::ledger_journal::persist_interval, [node_w, last_sync]() {
+		if (auto node_l = node_w.lock ())
+		{
+			node_l->ongoing_ledger_sync (last_sync);
+		}
+	});
+}
+
+// Make committed blocks durable and drop them from the journal
+void raze::node::ledger_sync ()
+{
+	uint64_t sequence;
+	{
+		// Blocks are journaled inside their write transaction, once we have the turn every one added so far has committed and is covered by the sync
+		raze::write_ticket ticket (write_scheduler, raze::write_priority::normal);
+		sequence = journal->last_added ();
+	}
+	journal->persist ();
+	auto status (mdb_env_sync (store.environment, 1));
+	if (status == 0)
+	{
+		journal->erase (sequence);
+	}
+	else
+	{
+		BOOST_LOG (log) << boost::str (boost::format ("Ledger sync failed: %1%") % mdb_strerror (status));
 	}
+}
+
+void raze::node::ongoing_store_flush ()
+{
+	write_scheduler.add (raze::write_priority::bulk, [this](MDB_txn * transaction_a) {
+		store.flush (transaction_a);
+	});
 	std::weak_ptr<raze::node> node_w (shared_from_this ());
 	alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [node_w]() {
 		if (auto node_l = node_w.lock ())
@@ -2013,7 +3198,7 @@ void raze::node::ongoing_store_flush ()
 
 void raze::node::backup_wallet ()
 {
-	raze::transaction transaction (store.environment, nullptr, false);
+	raze::transaction transaction (wallets.environment, nullptr, false);
 	for (auto i (wallets.items.begin ()), n (wallets.items.end ()); i != n; ++i)
 	{
 		auto backup_path (application_path / "backup");
@@ -2298,7 +3483,10 @@ public:
 				raze::account representative;
 				raze::pending_info pending;
 				raze::transaction transaction (node.store.environment, nullptr, false);
-				representative = wallet->store.representative (transaction);
+				{
+					raze::transaction wallet_transaction (wallet->store.environment, nullptr, false);
+					representative = wallet->store.representative (wallet_transaction);
+				}
 				auto error (node.store.pending_get (transaction, raze::pending_key (block_a.hashables.destination, block_a.hash ()), pending));
 				if (!error)
 				{
@@ -2372,6 +3560,34 @@ bool raze::block_arrival::recent (raze::block_hash const & hash_a)
 	return arrival.get<1> ().find (hash_a) != arrival.get<1> ().end ();
 }
 
+size_t constexpr raze::recent_votes::max_votes;
+
+void raze::recent_votes::add (std::shared_ptr<raze::vote> vote_a)
+{
+	auto digest_l (digest (*vote_a));
+	std::lock_guard<std::mutex> lock (mutex);
+	if (votes.push_back (digest_l).second)
+	{
+		while (votes.size () > max_votes)
+		{
+			votes.pop_front ();
+		}
+	}
+}
+
+bool raze::recent_votes::seen (std::shared_ptr<raze::vote> vote_a)
+{
+	auto digest_l (digest (*vote_a));
+	std::lock_guard<std::mutex> lock (mutex);
+	return votes.get<1> ().find (digest_l) != votes.get<1> ().end ();
+}
+
+raze::uint256_union raze::recent_votes::digest (raze::vote const & vote_a)
+{
+	// The vote hash already covers the block hash and sequence number, mixing in the account keeps votes from different representatives apart
+	return vote_a.hash () ^ vote_a.account;
+}
+
 std::unordered_set<raze::endpoint> raze::peer_container::random_set (size_t count_a)
 {
 	std::unordered_set<raze::endpoint> result;
@@ -2485,14 +3701,14 @@ bool raze::peer_container::empty ()
 	return size () == 0;
 }
 
-bool raze::peer_container::hash2_aware (raze::endpoint const & endpoint_a)
+bool raze::peer_container::vote_by_hash_aware (raze::endpoint const & endpoint_a)
 {
 	std::lock_guard<std::mutex> lock (mutex);
 	auto result (false);
 	auto existing (peers.find (endpoint_a));
 	if (existing != peers.end ())
 	{
-		result = existing->network_version >= 0x6;
+		result = existing->network_version >= raze::confirm_ack_hashes::version;
 	}
 	return result;
 }
@@ -2746,6 +3962,7 @@ last_winner (block_a)
 {
 	assert (node_a.store.block_exists (transaction_a, block_a->hash ()));
 	confirmed.clear ();
+	recount (transaction_a);
 	compute_rep_votes (transaction_a);
 }
 
@@ -2753,18 +3970,86 @@ void raze::election::compute_rep_votes (MDB_txn * transaction_a)
 {
 	node.wallets.foreach_representative (transaction_a, [this, transaction_a](raze::public_key const & pub_a, raze::raw_key const & prv_a) {
 		auto vote (this->node.store.vote_generate (transaction_a, pub_a, prv_a, last_winner));
-		this->votes.vote (vote.second);
+		this->tally_vote (transaction_a, vote);
 	});
 }
 
+void raze::election::recount (MDB_txn * transaction_a)
+{
+	bootstrap_weights = node.ledger.check_bootstrap_weights.load ();
+	quorum_weight = quorum_threshold (transaction_a, node.ledger);
+	minimum_weight = minimum_threshold (transaction_a, node.ledger);
+	rep_weights.clear ();
+	tally.clear ();
+	for (auto & i : votes.rep_votes)
+	{
+		auto & candidate (tally[i.second->hash ()]);
+		candidate.first += rep_weight (transaction_a, i.first);
+		candidate.second = i.second;
+	}
+}
+
+raze::uint128_t raze::election::rep_weight (MDB_txn * transaction_a, raze::account const & account_a)
+{
+	auto existing (rep_weights.find (account_a));
+	if (existing == rep_weights.end ())
+	{
+		existing = rep_weights.insert (std::make_pair (account_a, node.ledger.weight (transaction_a, account_a))).first;
+	}
+	return existing->second;
+}
+
+void raze::election::tally_vote (MDB_txn * transaction_a, std::shared_ptr<raze::vote> vote_a)
+{
+	std::shared_ptr<raze::block> previous;
+	auto existing (votes.rep_votes.find (vote_a->account));
+	if (existing != votes.rep_votes.end ())
+	{
+		previous = existing->second;
+	}
+	if (votes.vote (vote_a) != raze::tally_result::confirm)
+	{
+		auto weight (rep_weight (transaction_a, vote_a->account));
+		if (previous != nullptr)
+		{
+			auto old_candidate (tally.find (previous->hash ()));
+			assert (old_candidate != tally.end ());
+			old_candidate->second.first -= weight;
+		}
+		auto & candidate (tally[vote_a->block->hash ()]);
+		candidate.first += weight;
+		candidate.second = vote_a->block;
+	}
+}
+
+std::pair<raze::uint128_t, std::shared_ptr<raze::block>> raze::election::winner ()
+{
+	assert (!tally.empty ());
+	auto result (tally.begin ()->second);
+	for (auto i (tally.begin ()), n (tally.end ()); i != n; ++i)
+	{
+		if (i->second.first > result.first)
+		{
+			result = i->second;
+		}
+	}
+	return result;
+}
+
 void raze::election::broadcast_winner ()
 {
+	std::shared_ptr<raze::block> winner_l;
 	{
-		raze::transaction transaction (node.store.environment, nullptr, true);
+		// Generating our own votes advances their sequence numbers in the store so this still needs the writer
+		raze::scheduled_transaction transaction (node.write_scheduler, raze::write_priority::consensus);
+		std::lock_guard<std::mutex> lock (mutex);
+		// Weights shift as blocks are processed, refresh them once per announcement round
+		recount (transaction);
 		compute_rep_votes (transaction);
+		winner_l = last_winner;
 	}
 	raze::transaction transaction_a (node.store.environment, nullptr, false);
-	node.network.republish_block (transaction_a, last_winner);
+	node.network.republish_block (transaction_a, winner_l);
 }
 
 raze::uint128_t raze::election::quorum_threshold (MDB_txn * transaction_a, raze::ledger & ledger_a)
@@ -2779,15 +4064,14 @@ raze::uint128_t raze::election::minimum_threshold (MDB_txn * transaction_a, raze
 	return ledger_a.supply (transaction_a) / 16;
 }
 
-void raze::election::confirm_once (MDB_txn * transaction_a)
+bool raze::election::confirm_once (MDB_txn * transaction_a)
 {
-	if (!confirmed.test_and_set ())
+	auto result (!confirmed.test_and_set ());
+	if (result)
 	{
-		auto tally_l (node.ledger.tally (transaction_a, votes));
-		assert (tally_l.size () > 0);
-		auto winner (tally_l.begin ());
-		auto block_l (winner->second);
-		auto exceeded_min_threshold = winner->first > minimum_threshold (transaction_a, node.ledger);
+		auto winner_l (winner ());
+		auto block_l (winner_l.second);
+		auto exceeded_min_threshold = winner_l.first > minimum_weight;
 		if (!(*block_l == *last_winner))
 		{
 			if (exceeded_min_threshold)
@@ -2803,21 +4087,25 @@ void raze::election::confirm_once (MDB_txn * transaction_a)
 				BOOST_LOG (node.log) << boost::str (boost::format ("Retaining block %1%") % last_winner->hash ().to_string ());
 			}
 		}
-		auto winner_l (last_winner);
+		auto last_winner_l (last_winner);
 		auto node_l (node.shared ());
 		auto confirmation_action_l (confirmation_action);
-		node.background ([winner_l, confirmation_action_l, node_l, exceeded_min_threshold]() {
-			node_l->process_confirmed (winner_l);
-			confirmation_action_l (winner_l, exceeded_min_threshold);
+		node.background ([last_winner_l, confirmation_action_l, node_l, exceeded_min_threshold]() {
+			node_l->process_confirmed (last_winner_l);
+			confirmation_action_l (last_winner_l, exceeded_min_threshold);
 		});
 	}
+	return result;
 }
 
 bool raze::election::have_quorum (MDB_txn * transaction_a)
 {
-	auto tally_l (node.ledger.tally (transaction_a, votes));
-	assert (tally_l.size () > 0);
-	auto result (tally_l.begin ()->first > quorum_threshold (transaction_a, node.ledger));
+	if (node.ledger.check_bootstrap_weights.load () != bootstrap_weights)
+	{
+		// Weights switched from the bootstrap set to the ledger
+		recount (transaction_a);
+	}
+	auto result (winner ().first > quorum_weight);
 	return result;
 }
 
@@ -2826,12 +4114,18 @@ void raze::election::confirm_if_quorum (MDB_txn * transaction_a)
 	auto quorum (have_quorum (transaction_a));
 	if (quorum)
 	{
-		confirm_once (transaction_a);
+		if (confirm_once (transaction_a))
+		{
+			++node.active.quorum_confirmations;
+			// Cutoffs only end the election, quorum is what makes a block durably confirmed
+			node.confirmation_height_processor.add (last_winner->hash ());
+		}
 	}
 }
 
 void raze::election::confirm_cutoff (MDB_txn * transaction_a)
 {
+	std::lock_guard<std::mutex> lock (mutex);
 	if (node.config.logging.vote_logging ())
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("Vote tally weight %2% for root %1%") % votes.id.to_string () % last_winner->root ().to_string ());
@@ -2845,26 +4139,38 @@ void raze::election::confirm_cutoff (MDB_txn * transaction_a)
 
 void raze::election::vote (std::shared_ptr<raze::vote> vote_a)
 {
-	node.network.republish_vote (last_vote, vote_a);
+	// Tallying only reads weights, a fork switch found by confirm_once is handed to the block processor
+	raze::transaction transaction (node.store.environment, nullptr, false);
+	std::lock_guard<std::mutex> lock (mutex);
+	// Copies split from a hash vote are republished once as the original by vote_processor::observe
+	if (vote_a->hashes.empty ())
+	{
+		node.network.republish_vote (last_vote, vote_a);
+	}
 	last_vote = std::chrono::steady_clock::now ();
-	raze::transaction transaction (node.store.environment, nullptr, true);
 	//assert (node.store.vote_validate (transaction, vote_a).code != raze::vote_code::invalid);
-	votes.vote (vote_a);
+	tally_vote (transaction, vote_a);
 	confirm_if_quorum (transaction);
 }
 
+size_t raze::election::rep_count ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return votes.rep_votes.size ();
+}
+
 void raze::active_transactions::announce_votes ()
 {
 	std::vector<raze::block_hash> inactive;
-	raze::transaction transaction (node.store.environment, nullptr, true);
+	raze::scheduled_transaction transaction (node.write_scheduler, raze::write_priority::consensus);
 	std::lock_guard<std::mutex> lock (mutex);
 
+	size_t announcements (0);
 	{
-		size_t announcements (0);
 		auto i (roots.begin ());
 		auto n (roots.end ());
-		// Announce our decision for up to `announcements_per_interval' conflicts
-		for (; i != n && announcements < announcements_per_interval; ++i)
+		// Announce our decision for up to `announce_batch' conflicts
+		for (; i != n && announcements < announce_batch; ++i, ++announcements)
 		{
 			auto election_l (i->election);
 			node.background ([election_l]() { election_l->broadcast_winner (); });
@@ -2877,12 +4183,12 @@ void raze::active_transactions::announce_votes ()
 			}
 			else
 			{
-				unsigned announcements;
-				roots.modify (i, [&announcements](raze::conflict_info & info_a) {
-					announcements = ++info_a.announcements;
+				unsigned announcements_l;
+				roots.modify (i, [&announcements_l](raze::conflict_info & info_a) {
+					announcements_l = ++info_a.announcements;
 				});
 				// If more than one full announcement interval has passed and no one has voted on this block, we need to synchronize
-				if (announcements > 1 && i->election->votes.rep_votes.size () <= 1)
+				if (announcements_l > 1 && i->election->rep_count () <= 1)
 				{
 					node.bootstrap_initiator.bootstrap ();
 				}
@@ -2904,28 +4210,113 @@ void raze::active_transactions::announce_votes ()
 		assert (roots.find (*i) != roots.end ());
 		roots.erase (*i);
 	}
+	start_scheduled (transaction);
+	adjust_announcements (announcements);
 	auto now (std::chrono::steady_clock::now ());
 	auto node_l (node.shared ());
-	node.alarm.add (now + std::chrono::milliseconds (announce_interval_ms), [node_l]() { node_l->active.announce_votes (); });
+	node.alarm.add (now + std::chrono::milliseconds (announce_interval), [node_l]() { node_l->active.announce_votes (); });
+}
+
+void raze::active_transactions::start_scheduled (MDB_txn * transaction_a)
+{
+	while (roots.size () < elections_max && !scheduled.empty ())
+	{
+		auto next (scheduled.begin ());
+		auto block_l (next->block);
+		auto confirmation_action_l (next->confirmation_action);
+		scheduled.erase (next);
+		// The block may have been rolled back while waiting
+		if (roots.find (block_l->root ()) == roots.end () && node.store.block_exists (transaction_a, block_l->hash ()))
+		{
+			auto election (std::make_shared<raze::election> (transaction_a, node, block_l, confirmation_action_l));
+			roots.insert (raze::conflict_info{ block_l->root (), election, 0 });
+		}
+	}
+}
+
+void raze::active_transactions::adjust_announcements (size_t announced_a)
+{
+	auto quorum (quorum_confirmations.exchange (0));
+	auto backlog (!scheduled.empty () || roots.size () > announce_batch);
+	if (backlog && quorum * 2 >= announced_a)
+	{
+		// Most of what we announced reached quorum, the network can take more
+		announce_interval = std::max (announce_interval_min_ms, announce_interval / 2);
+		announce_batch = std::min<size_t> (announcements_max, announce_batch * 2);
+	}
+	else if (backlog)
+	{
+		// Elections are ending by cutoff instead of quorum, ease off on the network
+		announce_batch = std::max<size_t> (announcements_per_interval, announce_batch / 2);
+	}
+	else
+	{
+		announce_interval = std::min (announce_interval_ms, announce_interval * 2);
+		announce_batch = std::max<size_t> (announcements_per_interval, announce_batch / 2);
+	}
+}
+
+unsigned raze::active_transactions::priority (MDB_txn * transaction_a, raze::ledger & ledger_a, std::shared_ptr<raze::block> block_a)
+{
+	auto hash (block_a->hash ());
+	auto value (std::max (ledger_a.balance (transaction_a, hash), ledger_a.amount (transaction_a, hash)));
+	unsigned result (0);
+	for (; value != 0; value >>= 1)
+	{
+		++result;
+	}
+	return result;
 }
 
 void raze::active_transactions::stop ()
 {
 	std::lock_guard<std::mutex> lock (mutex);
 	roots.clear ();
+	scheduled.clear ();
 }
 
 bool raze::active_transactions::start (MDB_txn * transaction_a, std::shared_ptr<raze::block> block_a, std::function<void(std::shared_ptr<raze::block>, bool)> const & confirmation_action_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	auto root (block_a->root ());
-	auto existing (roots.find (root));
-	if (existing == roots.end ())
+	auto result (false);
+	if (node.ledger.block_confirmed (transaction_a, block_a->hash ()))
+	{
+		// Already settled by an earlier election, possibly before a restart
+		auto confirmation_action_l (confirmation_action_a);
+		node.background ([block_a, confirmation_action_l]() {
+			confirmation_action_l (block_a, true);
+		});
+	}
+	else
 	{
-		auto election (std::make_shared<raze::election> (transaction_a, node, block_a, confirmation_action_a));
-		roots.insert (raze::conflict_info{ root, election, 0 });
+		std::lock_guard<std::mutex> lock (mutex);
+		auto root (block_a->root ());
+		auto existing (roots.find (root));
+		result = existing != roots.end () || scheduled.get<1> ().find (root) != scheduled.get<1> ().end ();
+		if (!result)
+		{
+			if (roots.size () < elections_max)
+			{
+				auto election (std::make_shared<raze::election> (transaction_a, node, block_a, confirmation_action_a));
+				roots.insert (raze::conflict_info{ root, election, 0 });
+			}
+			else
+			{
+				// Too many elections running, wait for room behind anything more valuable
+				scheduled.insert (raze::scheduled_election{ root, block_a, confirmation_action_a, priority (transaction_a, node.ledger, block_a) });
+				if (scheduled.size () > scheduled_max)
+				{
+					auto last (std::prev (scheduled.end ()));
+					auto dropped (last->block);
+					auto dropped_action (last->confirmation_action);
+					scheduled.erase (last);
+					node.background ([dropped, dropped_action]() {
+						dropped_action (dropped, false);
+					});
+				}
+			}
+		}
 	}
-	return existing != roots.end ();
+	return result;
 }
 
 // Validate a vote and apply it to the current election if one exists
@@ -2953,8 +4344,31 @@ bool raze::active_transactions::active (raze::block const & block_a)
 	return roots.find (block_a.root ()) != roots.end ();
 }
 
+boost::optional<std::chrono::steady_clock::time_point> raze::active_transactions::last_vote (raze::block const & block_a)
+{
+	boost::optional<std::chrono::steady_clock::time_point> result;
+	std::shared_ptr<raze::election> election;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		auto existing (roots.find (block_a.root ()));
+		if (existing != roots.end ())
+		{
+			election = existing->election;
+		}
+	}
+	if (election)
+	{
+		std::lock_guard<std::mutex> lock (election->mutex);
+		result = election->last_vote;
+	}
+	return result;
+}
+
 raze::active_transactions::active_transactions (raze::node & node_a) :
-node (node_a)
+node (node_a),
+quorum_confirmations (0),
+announce_interval (announce_interval_ms),
+announce_batch (announcements_per_interval)
 {
 }
 
@@ -3006,9 +4420,12 @@ void raze::add_node_options (boost::program_options::options_description & descr
 		("account_key", "Get the public key for <account>")
 		("vacuum", "Compact database. If data_path is missing, the database in data directory is compacted.")
 		("data_path", boost::program_options::value<std::string> (), "Use the supplied path as the data directory")
+		("bootstrap_weights_generate", "Write the representative weights of the local ledger and its block count to <file>, for use as bootstrap_weights_file")
+		("debug_verify_ledger", "Check every account chain and the tables derived from them, reporting each inconsistency found")
 		("diagnostics", "Run internal diagnostics")
 		("key_create", "Generates a adhoc random keypair and prints it to stdout")
 		("key_expand", "Derive public key and account number from <key>")
+		("ledger_export", "Export accounts, blocks and pending entries as columnar files in to directory <file>")
 		("wallet_add_adhoc", "Insert <key> in to <wallet>")
 		("wallet_create", "Creates a new wallet and prints the ID")
 		("wallet_change_seed", "Changes seed for <wallet> to <key>")
@@ -3144,6 +4561,81 @@ bool raze::handle_node_options (boost::program_options::variables_map & vm)
 			std::cerr << "Vacuum failed" << std::endl;
 		}
 	}
+	else if (vm.count ("bootstrap_weights_generate"))
+	{
+		if (vm.count ("file") == 1)
+		{
+			auto output (vm["file"].as<std::string> ());
+			inactive_node node (data_path);
+			std::vector<uint8_t> weights;
+			size_t count (0);
+			{
+				raze::vectorstream stream (weights);
+				raze::transaction transaction (node.node->store.environment, nullptr, false);
+				raze::uint128_union block_height (node.node->store.block_count (transaction).sum ());
+				raze::write (stream, block_height);
+				for (auto i (node.node->store.representation_begin (transaction)), n (node.node->store.representation_end ()); i != n; ++i)
+				{
+					raze::account account (i->first.uint256 ());
+					raze::amount weight (node.node->store.representation_get (transaction, account));
+					if (!weight.is_zero ())
+					{
+						raze::write (stream, account.bytes);
+						raze::write (stream, weight.bytes);
+						++count;
+					}
+				}
+				std::cout << boost::str (boost::format ("Writing %1% representative weights at block count %2% to %3%\n") % count % block_height.number () % output);
+			}
+			std::ofstream file (output, std::ios::binary | std::ios::trunc);
+			file.write (reinterpret_cast<char const *> (weights.data ()), weights.size ());
+			file.close ();
+			if (file.fail ())
+			{
+				std::cerr << "Unable to write " << output << std::endl;
+				result = true;
+			}
+		}
+		else
+		{
+			std::cerr << "bootstrap_weights_generate command requires one <file> option\n";
+			result = true;
+		}
+	}
+	else if (vm.count ("debug_verify_ledger"))
+	{
+		inactive_node node (data_path);
+		raze::ledger_verifier verifier (node.node->ledger);
+		auto total (verifier.accounts_total ());
+		std::cout << boost::str (boost::format ("Verifying %1% accounts using %2% threads\n") % total % raze::block_store::scan_ranges ());
+		std::mutex mutex;
+		std::condition_variable condition;
+		auto finished (false);
+		std::thread progress ([&verifier, &mutex, &condition, &finished, total]() {
+			std::unique_lock<std::mutex> lock (mutex);
+			while (!condition.wait_for (lock, std::chrono::seconds (5), [&finished]() { return finished; }))
+			{
+				std::cout << boost::str (boost::format ("%1% of %2% accounts, %3% blocks verified, %4% anomalies\n") % verifier.accounts_checked % total % verifier.blocks_checked % verifier.anomaly_count);
+			}
+		});
+		auto anomalies (verifier.verify ());
+		{
+			std::lock_guard<std::mutex> lock (mutex);
+			finished = true;
+		}
+		condition.notify_all ();
+		progress.join ();
+		for (auto & i : verifier.anomalies)
+		{
+			std::cout << i << std::endl;
+		}
+		if (verifier.anomaly_count > verifier.anomalies.size ())
+		{
+			std::cout << boost::str (boost::format ("%1% further anomalies not shown\n") % (verifier.anomaly_count - verifier.anomalies.size ()));
+		}
+		std::cout << boost::str (boost::format ("Verified %1% accounts and %2% blocks, %3% anomalies found\n") % verifier.accounts_checked % verifier.blocks_checked % verifier.anomaly_count);
+		result = anomalies;
+	}
 	else if (vm.count ("diagnostics"))
 	{
 		inactive_node node (data_path);
@@ -3179,6 +4671,32 @@ bool raze::handle_node_options (boost::program_options::variables_map & vm)
 		          << "Public: " << pair.pub.to_string () << std::endl
 		          << "Account: " << pair.pub.to_account () << std::endl;
 	}
+	else if (vm.count ("ledger_export"))
+	{
+		if (vm.count ("file") == 1)
+		{
+			boost::filesystem::path output (vm["file"].as<std::string> ());
+			boost::filesystem::create_directories (output);
+			inactive_node node (data_path);
+			raze::ledger_exporter exporter (node.node->ledger, output);
+			auto begin (std::chrono::steady_clock::now ());
+			if (!exporter.run ())
+			{
+				auto elapsed (std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::steady_clock::now () - begin));
+				std::cout << boost::str (boost::format ("Exported %1% accounts, %2% blocks and %3% pending entries to %4% in %5% ms\n") % exporter.accounts % exporter.blocks % exporter.pending % output.string () % elapsed.count ());
+			}
+			else
+			{
+				std::cerr << "Unable to write export files to " << output.string () << std::endl;
+				result = true;
+			}
+		}
+		else
+		{
+			std::cerr << "ledger_export command requires one <file> option naming the output directory\n";
+			result = true;
+		}
+	}
 	else if (vm.count ("key_expand"))
 	{
 		if (vm.count ("key") == 1)
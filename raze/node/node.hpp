@@ -16,9 +16,11 @@
 #include <boost/iostreams/device/array.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/identity.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/random_access_index.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index_container.hpp>
 
 #include <miniupnpc.h>
@@ -38,11 +40,21 @@ class node;
 class election : public std::enable_shared_from_this<raze::election>
 {
 	std::function<void(std::shared_ptr<raze::block>, bool)> confirmation_action;
-	void confirm_once (MDB_txn *);
+	// Returns true if this call confirmed the election
+	bool confirm_once (MDB_txn *);
+	// Record a vote and move the representative's weight between candidates
+	void tally_vote (MDB_txn *, std::shared_ptr<raze::vote>);
+	raze::uint128_t rep_weight (MDB_txn *, raze::account const &);
 
 public:
 	election (MDB_txn *, raze::node &, std::shared_ptr<raze::block>, std::function<void(std::shared_ptr<raze::block>, bool)> const &);
 	void vote (std::shared_ptr<raze::vote>);
+	// Reload representative weights and thresholds from the ledger and rebuild the tally
+	void recount (MDB_txn *);
+	// Candidate with the most vote weight and its weight
+	std::pair<raze::uint128_t, std::shared_ptr<raze::block>> winner ();
+	// Number of representatives that have voted, including our initial candidate
+	size_t rep_count ();
 	// Check if we have vote quorum
 	bool have_quorum (MDB_txn *);
 	// Tell the network our view of the winner
@@ -60,6 +72,16 @@ public:
 	std::chrono::steady_clock::time_point last_vote;
 	std::shared_ptr<raze::block> last_winner;
 	std::atomic_flag confirmed;
+	// Running vote weight of each candidate block
+	std::unordered_map<raze::block_hash, std::pair<raze::uint128_t, std::shared_ptr<raze::block>>> tally;
+	// Weights of the representatives that voted, as of the last recount
+	std::unordered_map<raze::account, raze::uint128_t> rep_weights;
+	raze::uint128_t quorum_weight;
+	raze::uint128_t minimum_weight;
+	// Whether bootstrap weights were in use at the last recount
+	bool bootstrap_weights;
+	// Guards the vote state, votes are applied from several vote processor threads without holding the writer
+	std::mutex mutex;
 };
 class conflict_info
 {
@@ -69,6 +91,16 @@ public:
 	// Number of announcements in a row for this fork
 	unsigned announcements;
 };
+// Election waiting for room among the active elections
+class scheduled_election
+{
+public:
+	raze::block_hash root;
+	std::shared_ptr<raze::block> block;
+	std::function<void(std::shared_ptr<raze::block>, bool)> confirmation_action;
+	// Significant bits of the larger of the balance and amount the block moves, elections with the same priority start in arrival order
+	unsigned priority;
+};
 // Core class for determining concensus
 // Holds all active blocks i.e. recently added blocks that need confirmation
 class active_transactions
@@ -81,39 +113,82 @@ public:
 	void vote (std::shared_ptr<raze::vote>);
 	// Is the root of this block in the roots container
 	bool active (raze::block const &);
+	// When the block's election last saw a vote, empty if the block isn't actively settling
+	boost::optional<std::chrono::steady_clock::time_point> last_vote (raze::block const &);
 	void announce_votes ();
 	void stop ();
+	// Start waiting elections, highest priority first, while there's room
+	void start_scheduled (MDB_txn *);
+	// Speed announcements up while there's a backlog and the network keeps reaching quorum, relax them otherwise
+	void adjust_announcements (size_t);
+	static unsigned priority (MDB_txn *, raze::ledger &, std::shared_ptr<raze::block>);
 	boost::multi_index_container<
 	raze::conflict_info,
 	boost::multi_index::indexed_by<
 	boost::multi_index::ordered_unique<boost::multi_index::member<raze::conflict_info, raze::block_hash, &raze::conflict_info::root>>>>
 	roots;
+	boost::multi_index_container<
+	raze::scheduled_election,
+	boost::multi_index::indexed_by<
+	boost::multi_index::ordered_non_unique<boost::multi_index::member<raze::scheduled_election, unsigned, &raze::scheduled_election::priority>, std::greater<unsigned>>,
+	boost::multi_index::hashed_unique<boost::multi_index::member<raze::scheduled_election, raze::block_hash, &raze::scheduled_election::root>>>>
+	scheduled;
 	raze::node & node;
 	std::mutex mutex;
-	// Maximum number of conflicts to vote on per interval, lowest root hash first
+	// Elections confirmed by quorum since the last announcement round
+	std::atomic<unsigned> quorum_confirmations;
+	unsigned announce_interval;
+	size_t announce_batch;
+	// Minimum number of conflicts to vote on per interval, lowest root hash first
 	static unsigned constexpr announcements_per_interval = 32;
+	static unsigned constexpr announcements_max = 1024;
 	// After this many successive vote announcements, block is confirmed
 	static unsigned constexpr contigious_announcements = 4;
 	static unsigned constexpr announce_interval_ms = (raze::raze_network == raze::raze_networks::raze_test_network) ? 10 : 16000;
+	static unsigned constexpr announce_interval_min_ms = (raze::raze_network == raze::raze_networks::raze_test_network) ? 10 : 2000;
+	static size_t constexpr elections_max = 4096;
+	static size_t constexpr scheduled_max = 64 * 1024;
 };
+// Function scheduled on the alarm, an empty function is one that was cancelled or has already run
 class operation
 {
 public:
-	bool operator> (raze::operation const &) const;
-	std::chrono::steady_clock::time_point wakeup;
+	uint64_t tick;
 	std::function<void()> function;
 };
+/**
+ * Hierarchical timing wheel with millisecond ticks, each level has 256 slots so four levels cover 2^32 ms.
+ * Adding and cancelling are constant time. Operations cascade down a level as their tick comes closer and due ones are posted to the io_service in batches.
+ */
 class alarm
 {
 public:
+	static unsigned constexpr slot_bits = 8;
+	static size_t constexpr slots = size_t (1) << slot_bits;
+	static unsigned constexpr levels = 4;
+	static size_t constexpr dispatch_max = 64;
 	alarm (boost::asio::io_service &);
 	~alarm ();
-	void add (std::chrono::steady_clock::time_point const &, std::function<void()> const &);
+	std::shared_ptr<raze::operation> add (std::chrono::steady_clock::time_point const &, std::function<void()> const &);
+	// Drop the operation if it hasn't run yet, cancelled entries are discarded when their slot comes up
+	void cancel (std::shared_ptr<raze::operation> const &);
 	void run ();
+	void insert (std::shared_ptr<raze::operation> const &);
+	void cascade (unsigned);
+	void dispatch (std::vector<std::function<void()>> &);
+	// Milliseconds elapsed since the alarm started
+	uint64_t tick (std::chrono::steady_clock::time_point const &);
 	boost::asio::io_service & service;
 	std::mutex mutex;
 	std::condition_variable condition;
-	std::priority_queue<operation, std::vector<operation>, std::greater<operation>> operations;
+	std::chrono::steady_clock::time_point start;
+	// Next tick to process
+	uint64_t current;
+	// Tick the thread is sleeping until, adds before it need to wake the thread
+	uint64_t wakeup;
+	std::array<std::array<std::vector<std::shared_ptr<raze::operation>>, slots>, levels> wheels;
+	std::array<size_t, levels> counts;
+	bool stopped;
 	std::thread thread;
 };
 class gap_information
@@ -121,25 +196,43 @@ class gap_information
 public:
 	std::chrono::steady_clock::time_point arrival;
 	raze::block_hash hash;
-	std::unique_ptr<raze::votes> votes;
+	// Representatives with weight that voted for the block, each counted once in weight
+	std::unordered_set<raze::account> voters;
+	raze::uint128_t weight;
+	bool bootstrap_started;
 };
-class gap_cache
+class gap_cache_shard
 {
 public:
-	gap_cache (raze::node &);
-	void add (MDB_txn *, std::shared_ptr<raze::block>);
-	void vote (std::shared_ptr<raze::vote>);
-	raze::uint128_t bootstrap_threshold (MDB_txn *);
-	void purge_old ();
+	std::mutex mutex;
 	boost::multi_index_container<
 	raze::gap_information,
 	boost::multi_index::indexed_by<
 	boost::multi_index::ordered_non_unique<boost::multi_index::member<gap_information, std::chrono::steady_clock::time_point, &gap_information::arrival>>,
 	boost::multi_index::hashed_unique<boost::multi_index::member<gap_information, raze::block_hash, &gap_information::hash>>>>
 	blocks;
-	size_t const max = 256;
-	std::mutex mutex;
+};
+// Blocks missing a previous or source block, sharded by hash. Once enough weight votes for one we bootstrap to find what it depends on
+class gap_cache
+{
+public:
+	gap_cache (raze::node &);
+	void add (MDB_txn *, std::shared_ptr<raze::block>);
+	void erase (raze::block_hash const &);
+	// Count the voter's weight towards the voted block, or each hash of a vote by hash
+	void vote (std::shared_ptr<raze::vote>);
+	raze::uint128_t bootstrap_threshold (MDB_txn *);
+	// Bootstrap if the block is still missing, at most once per bootstrap_interval. A skipped check is retried while the block stays in the cache
+	void bootstrap_check (raze::block_hash const &);
+	void purge_old ();
+	raze::gap_cache_shard & shard (raze::block_hash const &);
+	static size_t const shard_count = 16;
+	size_t const shard_max;
+	std::array<raze::gap_cache_shard, shard_count> shards;
+	std::mutex bootstrap_mutex;
+	std::chrono::steady_clock::time_point bootstrap_last;
 	raze::node & node;
+	static std::chrono::milliseconds constexpr bootstrap_interval = std::chrono::milliseconds (raze::raze_network == raze::raze_networks::raze_test_network ? 5 : 30000);
 };
 class work_pool;
 class peer_information
@@ -195,7 +288,8 @@ public:
 	size_t size ();
 	size_t size_sqrt ();
 	bool empty ();
-	bool hash2_aware (raze::endpoint const &);
+	// True if the peer understands confirm_ack_hashes
+	bool vote_by_hash_aware (raze::endpoint const &);
 	std::mutex mutex;
 	raze::endpoint self;
 	boost::multi_index_container<
@@ -294,6 +388,23 @@ public:
 	arrival;
 	std::mutex mutex;
 };
+// Remembers the most recent votes that passed signature verification so copies rebroadcast by other peers can be dropped before being verified again
+// Votes are identified by account, sequence number and block hash
+class recent_votes
+{
+public:
+	void add (std::shared_ptr<raze::vote>);
+	bool seen (std::shared_ptr<raze::vote>);
+	static raze::uint256_union digest (raze::vote const &);
+	boost::multi_index_container<
+	raze::uint256_union,
+	boost::multi_index::indexed_by<
+	boost::multi_index::sequenced<>,
+	boost::multi_index::hashed_unique<boost::multi_index::identity<raze::uint256_union>>>>
+	votes;
+	std::mutex mutex;
+	static size_t constexpr max_votes = 64 * 1024;
+};
 class network
 {
 public:
@@ -307,7 +418,9 @@ public:
 	void republish_block (MDB_txn *, std::shared_ptr<raze::block>);
 	void republish (raze::block_hash const &, std::shared_ptr<std::vector<uint8_t>>, raze::endpoint);
 	void publish_broadcast (std::vector<raze::peer_information> &, std::unique_ptr<raze::block>);
-	void confirm_send (raze::confirm_ack const &, std::shared_ptr<std::vector<uint8_t>>, raze::endpoint const &);
+	void confirm_send (std::shared_ptr<raze::vote>, std::shared_ptr<std::vector<uint8_t>>, raze::endpoint const &);
+	// Send a vote as confirm_ack, or as confirm_ack_hashes to the peers that understand it when it votes by hash
+	void vote_send (std::shared_ptr<raze::vote>, std::vector<raze::endpoint> const &);
 	void merge_peers (std::array<raze::endpoint, 8> const &);
 	void send_keepalive (raze::endpoint const &);
 	void broadcast_confirm_req (std::shared_ptr<raze::block>);
@@ -394,6 +507,10 @@ public:
 	std::vector<std::string> preconfigured_peers;
 	std::vector<raze::account> preconfigured_representatives;
 	unsigned bootstrap_fraction_numerator;
+	// Blocks with missing dependencies tracked for votes at once
+	unsigned gap_cache_max;
+	// Seconds a gap block is kept waiting for votes before it's purged, the size cap bounds memory in the meantime
+	unsigned gap_cache_purge_age;
 	raze::amount receive_minimum;
 	raze::amount inactive_supply;
 	unsigned password_fanout;
@@ -406,6 +523,13 @@ public:
 	uint16_t callback_port;
 	std::string callback_target;
 	int lmdb_max_dbs;
+	// Milliseconds between forced syncs of the ledger, 0 syncs on every commit. Otherwise accepted blocks are journaled and replayed after a crash
+	// The ledger is then opened MDB_NOSYNC, which only survives an OS crash intact on filesystems that keep writes in order, like ext4 with data=ordered
+	unsigned lmdb_sync_interval;
+	// Representative weights used while bootstrapping, relative paths are in the data directory. Empty uses the weights built in for the live network
+	std::string bootstrap_weights_file;
+	// Serve RPC from a ledger written by another node process on this host, the network, block processing and wallets aren't started
+	bool read_only;
 	static std::chrono::seconds constexpr keepalive_period = std::chrono::seconds (60);
 	static std::chrono::seconds constexpr keepalive_cutoff = keepalive_period * 5;
 	static std::chrono::minutes constexpr wallet_backup_interval = std::chrono::minutes (5);
@@ -421,12 +545,52 @@ public:
 	raze::observer_set<> disconnect;
 	raze::observer_set<> started;
 };
+// Votes from the network are queued here and verified in batches by a pool of workers so vote floods don't stall the io threads
 class vote_processor
 {
 public:
 	vote_processor (raze::node &);
+	~vote_processor ();
+	// Queue a vote for processing, returns true if it was dropped because the queue is too full for this representative's weight
+	bool add (std::shared_ptr<raze::vote>, raze::endpoint const &);
+	// Validate and apply a single vote immediately
 	raze::vote_result vote (std::shared_ptr<raze::vote>, raze::endpoint);
+	void verify_votes (std::deque<std::pair<std::shared_ptr<raze::vote>, raze::endpoint>> &);
+	void apply (std::shared_ptr<raze::vote>, raze::vote_result const &, raze::endpoint const &);
+	// Notify observers, a vote by hash is applied as a vote for each of its blocks we have
+	void observe (std::shared_ptr<raze::vote>, raze::vote_code, raze::endpoint const &);
+	void process_loop ();
+	void flush ();
+	void stop ();
 	raze::node & node;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<std::pair<std::shared_ptr<raze::vote>, raze::endpoint>> votes;
+	unsigned processing;
+	bool stopped;
+	std::vector<std::thread> threads;
+	static size_t constexpr max_votes = 64 * 1024;
+	static size_t constexpr batch_max = 256;
+};
+// Collects the hashes of blocks we need to vote for so each representative signs one vote covering several of them
+class vote_generator
+{
+public:
+	vote_generator (raze::node &);
+	~vote_generator ();
+	// Vote for the hash and send the vote to the endpoints once enough hashes are collected or the wait expires
+	void add (raze::block_hash const &, std::vector<raze::endpoint> const &);
+	void stop ();
+	void run ();
+	void send (std::unique_lock<std::mutex> &);
+	raze::node & node;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<std::pair<raze::block_hash, std::vector<raze::endpoint>>> hashes;
+	bool stopped;
+	std::thread thread;
+	static std::chrono::milliseconds constexpr wait = std::chrono::milliseconds (raze::raze_network == raze::raze_networks::raze_test_network ? 1 : 50);
+	static size_t constexpr queue_max = 64 * 1024;
 };
 // The network is crawled for representatives by ocassionally sending a unicast confirm_req for a specific block and watching to see if it's acknowledged with a vote.
 class rep_crawler
@@ -438,6 +602,68 @@ public:
 	std::mutex mutex;
 	std::unordered_set<raze::block_hash> active;
 };
+enum class write_priority
+{
+	// Elections and votes, consensus stalls while these wait
+	consensus,
+	// Wallet and RPC writes
+	normal,
+	// Block processing, bootstrap and cache flushes
+	bulk
+};
+class write_scheduler;
+// Holds the ledger writer turn from construction to destruction
+class write_ticket
+{
+public:
+	write_ticket (raze::write_scheduler &, raze::write_priority);
+	~write_ticket ();
+	raze::write_scheduler & scheduler;
+};
+// Ledger write transaction that waits for its turn in the write scheduler before opening
+class scheduled_transaction : private raze::write_ticket, public raze::transaction
+{
+public:
+	scheduled_transaction (raze::write_scheduler &, raze::write_priority);
+};
+class write_scheduler_stats
+{
+public:
+	write_scheduler_stats ();
+	size_t waiting;
+	size_t queued;
+	uint64_t granted;
+	std::chrono::microseconds wait_total;
+	std::chrono::microseconds wait_max;
+};
+// Orders writers to the ledger environment by priority instead of leaving it to LMDB's writer mutex
+// The turn isn't reentrant, a thread holding it, including from an action passed to add, must not wait for it again
+class write_scheduler
+{
+public:
+	write_scheduler (raze::mdb_env &);
+	~write_scheduler ();
+	// Queue an action to run later in a write transaction shared with other queued actions
+	void add (raze::write_priority, std::function<void(MDB_txn *)> const &);
+	// True if a writer with higher priority is waiting for the turn
+	bool contended (raze::write_priority);
+	std::array<raze::write_scheduler_stats, 3> stats ();
+	void acquire (raze::write_priority);
+	void release ();
+	void run ();
+	void stop ();
+	raze::mdb_env & environment;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool held;
+	// Thread holding the turn, checked to catch a nested scheduled_transaction that would wait on itself forever
+	std::thread::id owner;
+	bool stopped;
+	std::array<raze::write_scheduler_stats, 3> counters;
+	std::array<std::deque<std::function<void(MDB_txn *)>>, 3> actions;
+	std::thread thread;
+	static size_t constexpr batch_max = 256;
+};
 class block_processor_item
 {
 public:
@@ -446,6 +672,32 @@ public:
 	std::shared_ptr<raze::block> block;
 	bool force;
 };
+// Blocks accepted since the ledger was last synced to disk, kept in a small environment of their own so they can be replayed after a crash
+class ledger_journal
+{
+public:
+	ledger_journal (bool &, boost::filesystem::path const &);
+	// Record a block the ledger accepted, forced blocks replaced a fork and are replayed with force
+	void add (raze::block const &, bool);
+	// Write out added blocks, returns the sequence number of the last one
+	uint64_t persist ();
+	// Sequence number the most recently added block is persisted with
+	uint64_t last_added ();
+	// Remove blocks up to and including sequence
+	void erase (uint64_t);
+	std::deque<raze::block_processor_item> blocks ();
+	raze::mdb_env environment;
+	MDB_dbi entries;
+	// Guards pending and added only so adding never waits on the journal sync
+	std::mutex mutex;
+	// Serialized blocks each followed by a force byte
+	std::vector<std::vector<uint8_t>> pending;
+	uint64_t added;
+	// Held across a persist so entries are numbered in the order they were added
+	std::mutex persist_mutex;
+	uint64_t sequence;
+	static std::chrono::milliseconds constexpr persist_interval = std::chrono::milliseconds (100);
+};
 // Processing blocks is a potentially long IO operation
 // This class isolates block insertion from other operations like servicing network operations
 class block_processor
@@ -458,8 +710,12 @@ public:
 	void add (raze::block_processor_item const &);
 	void process_receive_many (raze::block_processor_item const &);
 	void process_receive_many (std::deque<raze::block_processor_item> &);
-	raze::process_return process_receive_one (MDB_txn *, std::shared_ptr<raze::block>);
+	raze::process_return process_receive_one (MDB_txn *, std::shared_ptr<raze::block>, bool = false);
+	// Journal, log, queue as unchecked or report a fork for a block the ledger processed
+	void process_result (MDB_txn *, std::shared_ptr<raze::block>, raze::process_return const &, bool);
 	void process_blocks ();
+	// Blocks handed to the ledger in one process_batch call
+	static size_t constexpr batch_max = 256;
 
 private:
 	bool stopped;
@@ -469,6 +725,44 @@ private:
 	std::condition_variable condition;
 	raze::node & node;
 };
+// Blocks of an account walked bottom up, the confirmation height is raised to top once the source of every block up to it is confirmed
+class confirmation_range
+{
+public:
+	raze::account account;
+	// Height of the next block whose source is checked
+	uint64_t next;
+	uint64_t top;
+};
+// Raises account confirmation heights in batches as elections confirm blocks
+class confirmation_height_processor
+{
+public:
+	confirmation_height_processor (raze::node &);
+	~confirmation_height_processor ();
+	void add (raze::block_hash const &);
+	void stop ();
+	void run ();
+	// Confirm the pending blocks, their ancestors and every send received along the way, visiting at most blocks_max blocks
+	// Heights are only raised once everything below is confirmed, so walk state lost between transactions leaves no gaps
+	// Returns true if the walk isn't finished and continues in a later transaction
+	bool process (MDB_txn *);
+	// Start walking the block's account up to the block if it isn't confirmed yet
+	void walk (MDB_txn *, raze::block_hash const &);
+	raze::node & node;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<raze::block_hash> hashes;
+	// Walk state kept between write transactions, only used by the processor thread
+	std::vector<raze::block_hash> pending;
+	std::vector<raze::confirmation_range> ranges;
+	bool stopped;
+	std::thread thread;
+	static size_t constexpr batch_max = 256;
+	static size_t constexpr queue_max = 64 * 1024;
+	// Limits how long one bulk transaction holds the writer, confirming a block after an upgrade can reach most of the ledger
+	static size_t constexpr blocks_max = 4 * 1024;
+};
 class node : public std::enable_shared_from_this<raze::node>
 {
 public:
@@ -482,6 +776,8 @@ public:
 	}
 	void send_keepalive (raze::endpoint const &);
 	bool copy_with_compaction (boost::filesystem::path const &);
+	// Read a block count followed by account and weight pairs, the weights are used until the ledger reaches that many blocks
+	void load_bootstrap_weights (raze::stream &);
 	void keepalive (std::string const &, uint16_t);
 	void start ();
 	void stop ();
@@ -494,7 +790,7 @@ public:
 	void keepalive_preconfigured (std::vector<std::string> const &);
 	raze::block_hash latest (raze::account const &);
 	raze::uint128_t balance (raze::account const &);
-	std::unique_ptr<raze::block> block (raze::block_hash const &);
+	std::shared_ptr<raze::block> block (raze::block_hash const &);
 	std::pair<raze::uint128_t, raze::uint128_t> balance_pending (raze::account const &);
 	raze::uint128_t weight (raze::account const &);
 	raze::account representative (raze::account const &);
@@ -503,6 +799,8 @@ public:
 	void ongoing_rep_crawl ();
 	void ongoing_bootstrap ();
 	void ongoing_store_flush ();
+	void ongoing_ledger_sync (std::chrono::steady_clock::time_point const &);
+	void ledger_sync ();
 	void v10_v11_store_update ();
 	void backup_wallet ();
 	int price (raze::uint128_t const &, int);
@@ -516,6 +814,7 @@ public:
 	raze::work_pool & work;
 	boost::log::sources::logger_mt log;
 	raze::block_store store;
+	raze::write_scheduler write_scheduler;
 	raze::gap_cache gap_cache;
 	raze::ledger ledger;
 	raze::active_transactions active;
@@ -528,11 +827,15 @@ public:
 	raze::wallets wallets;
 	raze::port_mapping port_mapping;
 	raze::vote_processor vote_processor;
+	raze::vote_generator vote_generator;
+	raze::confirmation_height_processor confirmation_height_processor;
 	raze::rep_crawler rep_crawler;
 	unsigned warmed_up;
+	std::unique_ptr<raze::ledger_journal> journal;
 	raze::block_processor block_processor;
 	std::thread block_processor_thread;
 	raze::block_arrival block_arrival;
+	raze::recent_votes recent_votes;
 	static double constexpr price_max = 16.0;
 	static double constexpr free_cutoff = 1024.0;
 	static std::chrono::seconds constexpr period = std::chrono::seconds (60);
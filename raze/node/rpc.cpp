@@ -315,6 +315,7 @@ void raze::rpc_handler::account_info ()
 			response_l.put ("balance", balance);
 			response_l.put ("modified_timestamp", std::to_string (info.modified));
 			response_l.put ("block_count", std::to_string (info.block_count));
+			response_l.put ("confirmation_height", std::to_string (node.store.confirmation_height_get (transaction, account)));
 			if (representative)
 			{
 				auto block (node.store.block_get (transaction, info.rep_block));
@@ -373,7 +374,7 @@ void raze::rpc_handler::account_list ()
 		{
 			boost::property_tree::ptree response_l;
 			boost::property_tree::ptree accounts;
-			raze::transaction transaction (node.store.environment, nullptr, false);
+			raze::transaction transaction (node.wallets.environment, nullptr, false);
 			for (auto i (existing->second->store.begin (transaction)), j (existing->second->store.end ()); i != j; ++i)
 			{
 				boost::property_tree::ptree entry;
@@ -424,7 +425,7 @@ void raze::rpc_handler::account_move ()
 							account.decode_hex (i->second.get<std::string> (""));
 							accounts.push_back (account);
 						}
-						raze::transaction transaction (node.store.environment, nullptr, true);
+						raze::transaction transaction (node.wallets.environment, nullptr, true);
 						auto error (wallet->store.move (transaction, source->store, accounts));
 						boost::property_tree::ptree response_l;
 						response_l.put ("moved", error ? "0" : "1");
@@ -470,7 +471,7 @@ void raze::rpc_handler::account_remove ()
 			if (existing != node.wallets.items.end ())
 			{
 				auto wallet (existing->second);
-				raze::transaction transaction (node.store.environment, nullptr, true);
+				raze::transaction transaction (node.wallets.environment, nullptr, true);
 				if (existing->second->store.valid_password (transaction))
 				{
 					raze::account account_id;
@@ -580,9 +581,10 @@ void raze::rpc_handler::account_representative_set ()
 						}
 						if (work)
 						{
-							raze::transaction transaction (node.store.environment, nullptr, true);
+							raze::transaction block_transaction (node.store.environment, nullptr, false);
+							raze::transaction transaction (node.wallets.environment, nullptr, true);
 							raze::account_info info;
-							if (!node.store.account_get (transaction, account, info))
+							if (!node.store.account_get (block_transaction, account, info))
 							{
 								if (!raze::work_validate (info.head, work))
 								{
@@ -943,6 +945,7 @@ void raze::rpc_handler::blocks_info ()
 				std::string contents;
 				block->serialize_json (contents);
 				entry.put ("contents", contents);
+				entry.put ("confirmed", node.ledger.block_confirmed (transaction, hash) ? "1" : "0");
 				if (pending)
 				{
 					auto block_l (dynamic_cast<raze::send_block *> (block.get ()));
@@ -957,7 +960,7 @@ void raze::rpc_handler::blocks_info ()
 				if (source)
 				{
 					raze::block_hash source_hash (block->source ());
-					std::unique_ptr<raze::block> block_a (node.store.block_get (transaction, source_hash));
+					std::shared_ptr<raze::block> block_a (node.store.block_get (transaction, source_hash));
 					if (block_a != nullptr)
 					{
 						auto source_account (node.ledger.account (transaction, source_hash));
@@ -1115,7 +1118,8 @@ void raze::rpc_handler::block_create ()
 			auto existing (node.wallets.items.find (wallet));
 			if (existing != node.wallets.items.end ())
 			{
-				raze::transaction transaction (node.store.environment, nullptr, false);
+				raze::transaction block_transaction (node.store.environment, nullptr, false);
+				raze::transaction transaction (node.wallets.environment, nullptr, false);
 				auto unlock_check (existing->second->store.valid_password (transaction));
 				if (unlock_check)
 				{
@@ -1123,8 +1127,8 @@ void raze::rpc_handler::block_create ()
 					if (account_check != existing->second->store.end ())
 					{
 						existing->second->store.fetch (transaction, account, prv);
-						previous = node.ledger.latest (transaction, account);
-						balance = node.ledger.account_balance (transaction, account);
+						previous = node.ledger.latest (block_transaction, account);
+						balance = node.ledger.account_balance (block_transaction, account);
 					}
 					else
 					{
@@ -1407,17 +1411,24 @@ void raze::rpc_handler::delegators ()
 	{
 		boost::property_tree::ptree response_l;
 		boost::property_tree::ptree delegators;
-		raze::transaction transaction (node.store.environment, nullptr, false);
-		for (auto i (node.store.latest_begin (transaction)), n (node.store.latest_end ()); i != n; ++i)
-		{
-			raze::account_info info (i->second);
-			auto block (node.store.block_get (transaction, info.rep_block));
+		auto ranges (raze::block_store::scan_ranges ());
+		std::vector<std::vector<std::pair<raze::account, raze::amount>>> found (ranges);
+		node.store.parallel_scan (node.store.accounts, ranges, [this, &account, &found](size_t range_a, MDB_txn * transaction_a, raze::mdb_val const & key_a, raze::mdb_val const & value_a) {
+			raze::account_info info (value_a);
+			auto block (node.store.block_get (transaction_a, info.rep_block));
 			assert (block != nullptr);
 			if (block->representative () == account)
+			{
+				found[range_a].push_back (std::make_pair (key_a.uint256 (), info.balance));
+			}
+		});
+		for (auto & i : found)
+		{
+			for (auto & j : i)
 			{
 				std::string balance;
-				raze::uint128_union (info.balance).encode_dec (balance);
-				delegators.put (raze::account (i->first.uint256 ()).to_account (), balance);
+				j.second.encode_dec (balance);
+				delegators.put (j.first.to_account (), balance);
 			}
 		}
 		response_l.add_child ("delegators", delegators);
@@ -1436,18 +1447,18 @@ void raze::rpc_handler::delegators_count ()
 	auto error (account.decode_account (account_text));
 	if (!error)
 	{
-		uint64_t count (0);
-		raze::transaction transaction (node.store.environment, nullptr, false);
-		for (auto i (node.store.latest_begin (transaction)), n (node.store.latest_end ()); i != n; ++i)
-		{
-			raze::account_info info (i->second);
-			auto block (node.store.block_get (transaction, info.rep_block));
+		auto ranges (raze::block_store::scan_ranges ());
+		std::vector<uint64_t> counts (ranges, 0);
+		node.store.parallel_scan (node.store.accounts, ranges, [this, &account, &counts](size_t range_a, MDB_txn * transaction_a, raze::mdb_val const &, raze::mdb_val const & value_a) {
+			raze::account_info info (value_a);
+			auto block (node.store.block_get (transaction_a, info.rep_block));
 			assert (block != nullptr);
 			if (block->representative () == account)
 			{
-				++count;
+				++counts[range_a];
 			}
-		}
+		});
+		auto count (std::accumulate (counts.begin (), counts.end (), uint64_t (0)));
 		boost::property_tree::ptree response_l;
 		response_l.put ("count", std::to_string (count));
 		response (response_l);
@@ -1643,27 +1654,80 @@ void raze::rpc_handler::account_history ()
 		uint64_t count;
 		if (!decode_unsigned (count_text, count))
 		{
-			boost::property_tree::ptree response_l;
-			boost::property_tree::ptree history;
-			raze::transaction transaction (node.store.environment, nullptr, false);
-			auto hash (node.ledger.latest (transaction, account));
-			auto block (node.store.block_get (transaction, hash));
-			while (block != nullptr && count > 0)
+			uint64_t offset (0);
+			boost::optional<std::string> offset_text (request.get_optional<std::string> ("offset"));
+			if (!offset_text.is_initialized () || !decode_unsigned (offset_text.get (), offset))
 			{
-				boost::property_tree::ptree entry;
-				history_visitor visitor (*this, transaction, entry, hash);
-				block->visit (visitor);
-				if (!entry.empty ())
+				raze::transaction transaction (node.store.environment, nullptr, false);
+				raze::account_info info;
+				uint64_t head_height (0);
+				if (!node.store.account_get (transaction, account, info))
 				{
-					entry.put ("hash", hash.to_string ());
-					history.push_back (std::make_pair ("", entry));
+					head_height = info.block_count;
+				}
+				boost::optional<std::string> head_text (request.get_optional<std::string> ("head"));
+				if (head_text.is_initialized ())
+				{
+					raze::block_hash head;
+					if (!head.decode_hex (head_text.get ()))
+					{
+						if (node.store.block_height_get (transaction, head, head_height) || node.store.block_at_height (transaction, account, head_height) != head)
+						{
+							error = true;
+							error_response (response, "Block does not belong to account");
+						}
+					}
+					else
+					{
+						error = true;
+						error_response (response, "Invalid block hash");
+					}
+				}
+				if (!error)
+				{
+					boost::property_tree::ptree response_l;
+					boost::property_tree::ptree history;
+					if (head_height > offset && count > 0)
+					{
+						// Seek to the lowest block of the page and scan forward to the highest
+						auto high (head_height - offset);
+						auto low (high > count ? high - count + 1 : 1);
+						std::vector<raze::block_hash> hashes;
+						for (auto i (node.store.heights_begin (transaction, raze::height_key (account, low))), n (node.store.heights_end ()); i != n; ++i)
+						{
+							raze::height_key key (i->first);
+							if (key.account != account || key.height () > high)
+							{
+								break;
+							}
+							hashes.push_back (i->second.uint256 ());
+						}
+						for (auto i (hashes.rbegin ()), n (hashes.rend ()); i != n; ++i)
+						{
+							auto block (node.store.block_get (transaction, *i));
+							assert (block != nullptr);
+							boost::property_tree::ptree entry;
+							history_visitor visitor (*this, transaction, entry, *i);
+							block->visit (visitor);
+							if (!entry.empty ())
+							{
+								entry.put ("hash", i->to_string ());
+								history.push_back (std::make_pair ("", entry));
+							}
+						}
+						if (low > 1)
+						{
+							response_l.put ("previous", node.store.block_at_height (transaction, account, low - 1).to_string ());
+						}
+					}
+					response_l.add_child ("history", history);
+					response (response_l);
 				}
-				hash = block->previous ();
-				block = node.store.block_get (transaction, hash);
-				--count;
 			}
-			response_l.add_child ("history", history);
-			response (response_l);
+			else
+			{
+				error_response (response, "Invalid offset");
+			}
 		}
 		else
 		{
@@ -1819,11 +1883,20 @@ void raze::rpc_handler::ledger ()
 		}
 		else // Sorting
 		{
+			auto ranges (raze::block_store::scan_ranges ());
+			std::vector<std::vector<std::pair<raze::uint128_union, raze::account>>> found (ranges);
+			node.store.parallel_scan (node.store.accounts, ranges, [&start, &found](size_t range_a, MDB_txn *, raze::mdb_val const & key_a, raze::mdb_val const & value_a) {
+				raze::account account (key_a.uint256 ());
+				if (account.number () >= start.number ())
+				{
+					raze::uint128_union balance (raze::account_info (value_a).balance);
+					found[range_a].push_back (std::make_pair (balance, account));
+				}
+			});
 			std::vector<std::pair<raze::uint128_union, raze::account>> ledger_l;
-			for (auto i (node.store.latest_begin (transaction, start)), n (node.store.latest_end ()); i != n; ++i)
+			for (auto & i : found)
 			{
-				raze::uint128_union balance (raze::account_info (i->second).balance);
-				ledger_l.push_back (std::make_pair (balance, raze::account (i->first.uint256 ())));
+				ledger_l.insert (ledger_l.end (), i.begin (), i.end ());
 			}
 			std::sort (ledger_l.begin (), ledger_l.end ());
 			std::reverse (ledger_l.begin (), ledger_l.end ());
@@ -1962,7 +2035,7 @@ void raze::rpc_handler::password_change ()
 			auto existing (node.wallets.items.find (wallet));
 			if (existing != node.wallets.items.end ())
 			{
-				raze::transaction transaction (node.store.environment, nullptr, true);
+				raze::transaction transaction (node.wallets.environment, nullptr, true);
 				boost::property_tree::ptree response_l;
 				std::string password_text (request.get<std::string> ("password"));
 				auto error (existing->second->store.rekey (transaction, password_text));
@@ -2022,7 +2095,7 @@ void raze::rpc_handler::password_valid (bool wallet_locked = false)
 		auto existing (node.wallets.items.find (wallet));
 		if (existing != node.wallets.items.end ())
 		{
-			raze::transaction transaction (node.store.environment, nullptr, false);
+			raze::transaction transaction (node.wallets.environment, nullptr, false);
 			boost::property_tree::ptree response_l;
 			auto valid (existing->second->store.valid_password (transaction));
 			if (!wallet_locked)
@@ -2178,7 +2251,8 @@ void raze::rpc_handler::payment_begin ()
 		auto existing (node.wallets.items.find (id));
 		if (existing != node.wallets.items.end ())
 		{
-			raze::transaction transaction (node.store.environment, nullptr, true);
+			raze::transaction block_transaction (node.store.environment, nullptr, false);
+			raze::transaction transaction (node.wallets.environment, nullptr, true);
 			std::shared_ptr<raze::wallet> wallet (existing->second);
 			if (wallet->store.valid_password (transaction))
 			{
@@ -2197,7 +2271,7 @@ void raze::rpc_handler::payment_begin ()
 						}
 						else
 						{
-							if (!node.ledger.account_balance (transaction, account).is_zero ())
+							if (!node.ledger.account_balance (block_transaction, account).is_zero ())
 							{
 								BOOST_LOG (node.log) << boost::str (boost::format ("Skipping account %1% for use as a transaction account since it's balance isn't zero") % account.to_account ());
 								account.clear ();
@@ -2243,7 +2317,7 @@ void raze::rpc_handler::payment_init ()
 	raze::uint256_union id;
 	if (!id.decode_hex (id_text))
 	{
-		raze::transaction transaction (node.store.environment, nullptr, true);
+		raze::transaction transaction (node.wallets.environment, nullptr, true);
 		auto existing (node.wallets.items.find (id));
 		if (existing != node.wallets.items.end ())
 		{
@@ -2282,7 +2356,8 @@ void raze::rpc_handler::payment_end ()
 	raze::uint256_union id;
 	if (!id.decode_hex (id_text))
 	{
-		raze::transaction transaction (node.store.environment, nullptr, false);
+		raze::transaction block_transaction (node.store.environment, nullptr, false);
+		raze::transaction transaction (node.wallets.environment, nullptr, false);
 		auto existing (node.wallets.items.find (id));
 		if (existing != node.wallets.items.end ())
 		{
@@ -2293,7 +2368,7 @@ void raze::rpc_handler::payment_end ()
 				auto existing (wallet->store.find (transaction, account));
 				if (existing != wallet->store.end ())
 				{
-					if (node.ledger.account_balance (transaction, account).is_zero ())
+					if (node.ledger.account_balance (block_transaction, account).is_zero ())
 					{
 						wallet->free_accounts.insert (account);
 						boost::property_tree::ptree response_l;
@@ -2380,7 +2455,7 @@ void raze::rpc_handler::process ()
 			raze::process_return result;
 			std::shared_ptr<raze::block> block_a (std::move (block));
 			{
-				raze::transaction transaction (node.store.environment, nullptr, true);
+				raze::scheduled_transaction transaction (node.write_scheduler, raze::write_priority::normal);
 				result = node.block_processor.process_receive_one (transaction, block_a);
 			}
 			switch (result.code)
@@ -2515,7 +2590,8 @@ void raze::rpc_handler::receive ()
 				auto error (account.decode_account (account_text));
 				if (!error)
 				{
-					raze::transaction transaction (node.store.environment, nullptr, false);
+					raze::transaction block_transaction (node.store.environment, nullptr, false);
+					raze::transaction transaction (node.wallets.environment, nullptr, false);
 					auto account_check (existing->second->store.find (transaction, account));
 					if (account_check != existing->second->store.end ())
 					{
@@ -2524,10 +2600,10 @@ void raze::rpc_handler::receive ()
 						auto error (hash.decode_hex (hash_text));
 						if (!error)
 						{
-							auto block (node.store.block_get (transaction, hash));
+							auto block (node.store.block_get (block_transaction, hash));
 							if (block != nullptr)
 							{
-								if (node.store.pending_exists (transaction, raze::pending_key (account, hash)))
+								if (node.store.pending_exists (block_transaction, raze::pending_key (account, hash)))
 								{
 									uint64_t work (0);
 									boost::optional<std::string> work_text (request.get_optional<std::string> ("work"));
@@ -2543,7 +2619,7 @@ void raze::rpc_handler::receive ()
 									{
 										raze::account_info info;
 										raze::uint256_union head;
-										if (!node.store.account_get (transaction, account, info))
+										if (!node.store.account_get (block_transaction, account, info))
 										{
 											head = info.head;
 										}
@@ -2553,7 +2629,7 @@ void raze::rpc_handler::receive ()
 										}
 										if (!raze::work_validate (head, work))
 										{
-											raze::transaction transaction_a (node.store.environment, nullptr, true);
+											raze::transaction transaction_a (node.wallets.environment, nullptr, true);
 											existing->second->store.work_put (transaction_a, account, work);
 										}
 										else
@@ -2685,12 +2761,17 @@ void raze::rpc_handler::representatives ()
 	}
 	else // Sorting
 	{
+		auto ranges (raze::block_store::scan_ranges ());
+		std::vector<std::vector<std::pair<raze::uint128_union, std::string>>> found (ranges);
+		node.store.parallel_scan (node.store.representation, ranges, [this, &found](size_t range_a, MDB_txn * transaction_a, raze::mdb_val const & key_a, raze::mdb_val const &) {
+			raze::account account (key_a.uint256 ());
+			auto amount (node.store.representation_get (transaction_a, account));
+			found[range_a].push_back (std::make_pair (amount, account.to_account ()));
+		});
 		std::vector<std::pair<raze::uint128_union, std::string>> representation;
-		for (auto i (node.store.representation_begin (transaction)), n (node.store.representation_end ()); i != n; ++i)
+		for (auto & i : found)
 		{
-			raze::account account (i->first.uint256 ());
-			auto amount (node.store.representation_get (transaction, account));
-			representation.push_back (std::make_pair (amount, account.to_account ()));
+			representation.insert (representation.end (), i.begin (), i.end ());
 		}
 		std::sort (representation.begin (), representation.end ());
 		std::reverse (representation.begin (), representation.end ());
@@ -2752,7 +2833,7 @@ void raze::rpc_handler::republish ()
 				if (sources != 0) // Republish source chain
 				{
 					raze::block_hash source (block->source ());
-					std::unique_ptr<raze::block> block_a (node.store.block_get (transaction, source));
+					std::shared_ptr<raze::block> block_a (node.store.block_get (transaction, source));
 					std::vector<raze::block_hash> hashes;
 					while (block_a != nullptr && hashes.size () < sources)
 					{
@@ -2785,7 +2866,7 @@ void raze::rpc_handler::republish ()
 						if (!exists)
 						{
 							raze::block_hash previous (node.ledger.latest (transaction, destination));
-							std::unique_ptr<raze::block> block_d (node.store.block_get (transaction, previous));
+							std::shared_ptr<raze::block> block_d (node.store.block_get (transaction, previous));
 							raze::block_hash source;
 							std::vector<raze::block_hash> hashes;
 							while (block_d != nullptr && hash != source)
@@ -2911,9 +2992,10 @@ void raze::rpc_handler::send ()
 							}
 							raze::uint128_t balance (0);
 							{
-								raze::transaction transaction (node.store.environment, nullptr, work != 0); // false if no "work" in request, true if work > 0
+								raze::transaction block_transaction (node.store.environment, nullptr, false);
+								raze::transaction transaction (node.wallets.environment, nullptr, work != 0); // false if no "work" in request, true if work > 0
 								raze::account_info info;
-								if (!node.store.account_get (transaction, source, info))
+								if (!node.store.account_get (block_transaction, source, info))
 								{
 									balance = (info.balance).number ();
 								}
@@ -3036,7 +3118,7 @@ void raze::rpc_handler::unchecked_clear ()
 {
 	if (rpc.config.enable_control)
 	{
-		raze::transaction transaction (node.store.environment, nullptr, true);
+		raze::scheduled_transaction transaction (node.write_scheduler, raze::write_priority::normal);
 		node.store.unchecked_clear (transaction);
 		boost::property_tree::ptree response_l;
 		response_l.put ("success", "");
@@ -3212,12 +3294,13 @@ void raze::rpc_handler::wallet_balance_total ()
 		{
 			raze::uint128_t balance (0);
 			raze::uint128_t pending (0);
-			raze::transaction transaction (node.store.environment, nullptr, false);
+			raze::transaction block_transaction (node.store.environment, nullptr, false);
+			raze::transaction transaction (node.wallets.environment, nullptr, false);
 			for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
 			{
 				raze::account account (i->first.uint256 ());
-				balance = balance + node.ledger.account_balance (transaction, account);
-				pending = pending + node.ledger.account_pending (transaction, account);
+				balance = balance + node.ledger.account_balance (block_transaction, account);
+				pending = pending + node.ledger.account_pending (block_transaction, account);
 			}
 			boost::property_tree::ptree response_l;
 			response_l.put ("balance", balance.convert_to<std::string> ());
@@ -3257,15 +3340,16 @@ void raze::rpc_handler::wallet_balances ()
 		{
 			boost::property_tree::ptree response_l;
 			boost::property_tree::ptree balances;
-			raze::transaction transaction (node.store.environment, nullptr, false);
+			raze::transaction block_transaction (node.store.environment, nullptr, false);
+			raze::transaction transaction (node.wallets.environment, nullptr, false);
 			for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
 			{
 				raze::account account (i->first.uint256 ());
-				raze::uint128_t balance = node.ledger.account_balance (transaction, account);
+				raze::uint128_t balance = node.ledger.account_balance (block_transaction, account);
 				if (threshold.is_zero ())
 				{
 					boost::property_tree::ptree entry;
-					raze::uint128_t pending = node.ledger.account_pending (transaction, account);
+					raze::uint128_t pending = node.ledger.account_pending (block_transaction, account);
 					entry.put ("balance", balance.convert_to<std::string> ());
 					entry.put ("pending", pending.convert_to<std::string> ());
 					balances.push_back (std::make_pair (account.to_account (), entry));
@@ -3275,7 +3359,7 @@ void raze::rpc_handler::wallet_balances ()
 					if (balance >= threshold.number ())
 					{
 						boost::property_tree::ptree entry;
-						raze::uint128_t pending = node.ledger.account_pending (transaction, account);
+						raze::uint128_t pending = node.ledger.account_pending (block_transaction, account);
 						entry.put ("balance", balance.convert_to<std::string> ());
 						entry.put ("pending", pending.convert_to<std::string> ());
 						balances.push_back (std::make_pair (account.to_account (), entry));
@@ -3313,7 +3397,7 @@ void raze::rpc_handler::wallet_change_seed ()
 				auto existing (node.wallets.items.find (wallet));
 				if (existing != node.wallets.items.end ())
 				{
-					raze::transaction transaction (node.store.environment, nullptr, true);
+					raze::transaction transaction (node.wallets.environment, nullptr, true);
 					if (existing->second->store.valid_password (transaction))
 					{
 						existing->second->store.seed_set (transaction, seed);
@@ -3362,7 +3446,7 @@ void raze::rpc_handler::wallet_contains ()
 			auto existing (node.wallets.items.find (wallet));
 			if (existing != node.wallets.items.end ())
 			{
-				raze::transaction transaction (node.store.environment, nullptr, false);
+				raze::transaction transaction (node.wallets.environment, nullptr, false);
 				auto exists (existing->second->store.find (transaction, account) != existing->second->store.end ());
 				boost::property_tree::ptree response_l;
 				response_l.put ("exists", exists ? "1" : "0");
@@ -3390,7 +3474,7 @@ void raze::rpc_handler::wallet_create ()
 	{
 		raze::keypair wallet_id;
 		node.wallets.create (wallet_id.pub);
-		raze::transaction transaction (node.store.environment, nullptr, false);
+		raze::transaction transaction (node.wallets.environment, nullptr, false);
 		auto existing (node.wallets.items.find (wallet_id.pub));
 		if (existing != node.wallets.items.end ())
 		{
@@ -3451,7 +3535,7 @@ void raze::rpc_handler::wallet_export ()
 		auto existing (node.wallets.items.find (wallet));
 		if (existing != node.wallets.items.end ())
 		{
-			raze::transaction transaction (node.store.environment, nullptr, false);
+			raze::transaction transaction (node.wallets.environment, nullptr, false);
 			std::string json;
 			existing->second->store.serialize_json (transaction, json);
 			boost::property_tree::ptree response_l;
@@ -3481,11 +3565,12 @@ void raze::rpc_handler::wallet_frontiers ()
 		{
 			boost::property_tree::ptree response_l;
 			boost::property_tree::ptree frontiers;
-			raze::transaction transaction (node.store.environment, nullptr, false);
+			raze::transaction block_transaction (node.store.environment, nullptr, false);
+			raze::transaction transaction (node.wallets.environment, nullptr, false);
 			for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
 			{
 				raze::account account (i->first.uint256 ());
-				auto latest (node.ledger.latest (transaction, account));
+				auto latest (node.ledger.latest (block_transaction, account));
 				if (!latest.is_zero ())
 				{
 					frontiers.put (account.to_account (), latest.to_string ());
@@ -3515,7 +3600,7 @@ void raze::rpc_handler::wallet_key_valid ()
 		auto existing (node.wallets.items.find (wallet));
 		if (existing != node.wallets.items.end ())
 		{
-			raze::transaction transaction (node.store.environment, nullptr, false);
+			raze::transaction transaction (node.wallets.environment, nullptr, false);
 			auto valid (existing->second->store.valid_password (transaction));
 			boost::property_tree::ptree response_l;
 			response_l.put ("valid", valid ? "1" : "0");
@@ -3545,9 +3630,7 @@ void raze::rpc_handler::wallet_lock ()
 			if (existing != node.wallets.items.end ())
 			{
 				boost::property_tree::ptree response_l;
-				raze::raw_key empty;
-				empty.data.clear ();
-				existing->second->store.password.value_set (empty);
+				existing->second->lock ();
 				response_l.put ("locked", "1");
 				response (response_l);
 			}
@@ -3605,13 +3688,14 @@ void raze::rpc_handler::wallet_pending ()
 			}
 			boost::property_tree::ptree response_l;
 			boost::property_tree::ptree pending;
-			raze::transaction transaction (node.store.environment, nullptr, false);
+			raze::transaction block_transaction (node.store.environment, nullptr, false);
+			raze::transaction transaction (node.wallets.environment, nullptr, false);
 			for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
 			{
 				raze::account account (i->first.uint256 ());
 				boost::property_tree::ptree peers_l;
 				raze::account end (account.number () + 1);
-				for (auto ii (node.store.pending_begin (transaction, raze::pending_key (account, 0))), nn (node.store.pending_begin (transaction, raze::pending_key (end, 0))); ii != nn && peers_l.size () < count; ++ii)
+				for (auto ii (node.store.pending_begin (block_transaction, raze::pending_key (account, 0))), nn (node.store.pending_begin (block_transaction, raze::pending_key (end, 0))); ii != nn && peers_l.size () < count; ++ii)
 				{
 					raze::pending_key key (ii->first);
 					if (threshold.is_zero () && !source)
@@ -3668,7 +3752,7 @@ void raze::rpc_handler::wallet_representative ()
 		auto existing (node.wallets.items.find (wallet));
 		if (existing != node.wallets.items.end ())
 		{
-			raze::transaction transaction (node.store.environment, nullptr, false);
+			raze::transaction transaction (node.wallets.environment, nullptr, false);
 			boost::property_tree::ptree response_l;
 			response_l.put ("representative", existing->second->store.representative (transaction).to_account ());
 			response (response_l);
@@ -3701,7 +3785,7 @@ void raze::rpc_handler::wallet_representative_set ()
 				auto error (representative.decode_account (representative_text));
 				if (!error)
 				{
-					raze::transaction transaction (node.store.environment, nullptr, true);
+					raze::transaction transaction (node.wallets.environment, nullptr, true);
 					existing->second->store.representative_set (transaction, representative);
 					boost::property_tree::ptree response_l;
 					response_l.put ("set", "1");
@@ -3747,24 +3831,25 @@ void raze::rpc_handler::wallet_republish ()
 				{
 					boost::property_tree::ptree response_l;
 					boost::property_tree::ptree blocks;
-					raze::transaction transaction (node.store.environment, nullptr, false);
+					raze::transaction block_transaction (node.store.environment, nullptr, false);
+					raze::transaction transaction (node.wallets.environment, nullptr, false);
 					for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
 					{
 						raze::account account (i->first.uint256 ());
-						auto latest (node.ledger.latest (transaction, account));
-						std::unique_ptr<raze::block> block;
+						auto latest (node.ledger.latest (block_transaction, account));
+						std::shared_ptr<raze::block> block;
 						std::vector<raze::block_hash> hashes;
 						while (!latest.is_zero () && hashes.size () < count)
 						{
 							hashes.push_back (latest);
-							block = node.store.block_get (transaction, latest);
+							block = node.store.block_get (block_transaction, latest);
 							latest = block->previous ();
 						}
 						std::reverse (hashes.begin (), hashes.end ());
 						for (auto & hash : hashes)
 						{
-							block = node.store.block_get (transaction, hash);
-							node.network.republish_block (transaction, std::move (block));
+							block = node.store.block_get (block_transaction, hash);
+							node.network.republish_block (block_transaction, std::move (block));
 							;
 							boost::property_tree::ptree entry;
 							entry.put ("", hash.to_string ());
@@ -3809,7 +3894,7 @@ void raze::rpc_handler::wallet_work_get ()
 			{
 				boost::property_tree::ptree response_l;
 				boost::property_tree::ptree works;
-				raze::transaction transaction (node.store.environment, nullptr, false);
+				raze::transaction transaction (node.wallets.environment, nullptr, false);
 				for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
 				{
 					raze::account account (i->first.uint256 ());
@@ -3911,7 +3996,7 @@ void raze::rpc_handler::work_get ()
 				auto error (account.decode_account (account_text));
 				if (!error)
 				{
-					raze::transaction transaction (node.store.environment, nullptr, false);
+					raze::transaction transaction (node.wallets.environment, nullptr, false);
 					auto account_check (existing->second->store.find (transaction, account));
 					if (account_check != existing->second->store.end ())
 					{
@@ -3964,7 +4049,7 @@ void raze::rpc_handler::work_set ()
 				auto error (account.decode_account (account_text));
 				if (!error)
 				{
-					raze::transaction transaction (node.store.environment, nullptr, true);
+					raze::transaction transaction (node.wallets.environment, nullptr, true);
 					auto account_check (existing->second->store.find (transaction, account));
 					if (account_check != existing->second->store.end ())
 					{
@@ -4092,6 +4177,25 @@ void raze::rpc_handler::work_peers ()
 	}
 }
 
+void raze::rpc_handler::write_queue ()
+{
+	auto stats (node.write_scheduler.stats ());
+	std::array<char const *, 3> names = { { "consensus", "normal", "bulk" } };
+	boost::property_tree::ptree response_l;
+	for (size_t i (0), n (stats.size ()); i < n; ++i)
+	{
+		auto & stats_l (stats[i]);
+		boost::property_tree::ptree entry;
+		entry.put ("waiting", std::to_string (stats_l.waiting));
+		entry.put ("queued", std::to_string (stats_l.queued));
+		entry.put ("granted", std::to_string (stats_l.granted));
+		entry.put ("wait_average_us", std::to_string (stats_l.granted > 0 ? stats_l.wait_total.count () / stats_l.granted : 0));
+		entry.put ("wait_max_us", std::to_string (stats_l.wait_max.count ()));
+		response_l.add_child (names[i], entry);
+	}
+	response (response_l);
+}
+
 void raze::rpc_handler::work_peers_clear ()
 {
 	if (rpc.config.enable_control)
@@ -4166,6 +4270,13 @@ void reprocess_body (std::string & body, boost::property_tree::ptree & tree_a)
 	boost::property_tree::write_json (stream, tree_a);
 	body = stream.str ();
 }
+
+// Actions that only read the ledger or do local computation, the rest need wallets, the network or ledger writes
+bool read_only_action (std::string const & action_a)
+{
+	static std::unordered_set<std::string> const actions ({ "account_balance", "account_block_count", "account_get", "account_history", "account_info", "account_key", "account_representative", "account_weight", "accounts_balances", "accounts_frontiers", "accounts_pending", "available_supply", "block", "blocks", "blocks_info", "block_account", "block_count", "block_count_type", "successors", "chain", "delegators", "delegators_count", "deterministic_key", "frontiers", "frontier_count", "history", "key_create", "key_expand", "kraze_from_raw", "kraze_to_raw", "ledger", "mraze_from_raw", "mraze_to_raw", "pending", "pending_exists", "raze_from_raw", "raze_to_raw", "representatives", "stop", "unchecked", "unchecked_get", "unchecked_keys", "validate_account_number", "version", "work_cancel", "work_generate", "work_validate" });
+	return actions.count (action_a) != 0;
+}
 }
 
 void raze::rpc_handler::process_request ()
@@ -4175,6 +4286,11 @@ void raze::rpc_handler::process_request ()
 		std::stringstream istream (body);
 		boost::property_tree::read_json (istream, request);
 		std::string action (request.get<std::string> ("action"));
+		if (node.config.read_only && !read_only_action (action))
+		{
+			error_response (response, "Action is not available on a read only node");
+			return;
+		}
 		if (action == "password_enter")
 		{
 			password_enter ();
@@ -4585,6 +4701,10 @@ void raze::rpc_handler::process_request ()
 		{
 			work_peers_clear ();
 		}
+		else if (action == "write_queue")
+		{
+			write_queue ();
+		}
 		else
 		{
 			error_response (response, "Unknown command");
@@ -4612,7 +4732,8 @@ response (response_a)
 void raze::payment_observer::start (uint64_t timeout)
 {
 	auto this_l (shared_from_this ());
-	rpc.node.alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (timeout), [this_l]() {
+	std::lock_guard<std::mutex> lock (mutex);
+	expiry = rpc.node.alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (timeout), [this_l]() {
 		this_l->complete (raze::payment_status::nothing);
 	});
 }
@@ -4660,6 +4781,10 @@ void raze::payment_observer::complete (raze::payment_status status)
 				break;
 			}
 		}
+		{
+			std::lock_guard<std::mutex> lock (mutex);
+			rpc.node.alarm.cancel (expiry);
+		}
 		std::lock_guard<std::mutex> lock (rpc.mutex);
 		assert (rpc.payment_observers.find (account) != rpc.payment_observers.end ());
 		rpc.payment_observers.erase (account);
@@ -40,6 +40,7 @@ enum class payment_status
 	success // Amount received
 };
 class wallet;
+class operation;
 class payment_observer;
 class rpc
 {
@@ -84,6 +85,8 @@ public:
 	raze::amount amount;
 	std::function<void(boost::property_tree::ptree const &)> response;
 	std::atomic_flag completed;
+	// Completes with nothing when the wait runs out, cancelled on completion
+	std::shared_ptr<raze::operation> expiry;
 };
 class rpc_handler : public std::enable_shared_from_this<raze::rpc_handler>
 {
@@ -185,6 +188,7 @@ public:
 	void work_peer_add ();
 	void work_peers ();
 	void work_peers_clear ();
+	void write_queue ();
 	std::string body;
 	raze::node & node;
 	raze::rpc & rpc;
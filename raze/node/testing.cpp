@@ -130,7 +130,7 @@ void raze::system::generate_rollback (raze::node & node_a, std::vector<raze::acc
 {
 	raze::block_hash current (node_a.latest (get_random_account (accounts_a)));
 	raze::block_hash target (current);
-	raze::transaction transaction (node_a.store.environment, nullptr, true);
+	raze::scheduled_transaction transaction (node_a.write_scheduler, raze::write_priority::normal);
 	while (!current.is_zero ())
 	{
 		auto block1 (node_a.store.block_get (transaction, current));
@@ -173,7 +173,7 @@ void raze::system::generate_receive (raze::node & node_a)
 			raze::pending_info info (i->second);
 			auto block (node_a.store.block_get (transaction, send_hash.hash));
 			assert (dynamic_cast<raze::send_block *> (block.get ()) != nullptr);
-			send_block.reset (static_cast<raze::send_block *> (block.release ()));
+			send_block = std::static_pointer_cast<raze::send_block> (block);
 		}
 	}
 	if (send_block != nullptr)
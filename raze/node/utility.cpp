@@ -12,23 +12,27 @@ boost::filesystem::path raze::unique_path ()
 	return result;
 }
 
-raze::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a, int max_dbs)
+raze::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a, int max_dbs, size_t map_size_a, bool read_only_a) :
+commit_failed ([](uint64_t) {})
 {
 	boost::system::error_code error;
 	if (path_a.has_parent_path ())
 	{
-		boost::filesystem::create_directories (path_a.parent_path (), error);
+		if (!read_only_a)
+		{
+			boost::filesystem::create_directories (path_a.parent_path (), error);
+		}
 		if (!error)
 		{
 			auto status1 (mdb_env_create (&environment));
 			assert (status1 == 0);
 			auto status2 (mdb_env_set_maxdbs (environment, max_dbs));
 			assert (status2 == 0);
-			auto status3 (mdb_env_set_mapsize (environment, 1ULL * 1024 * 1024 * 1024 * 1024)); // 1 Terabyte
+			auto status3 (mdb_env_set_mapsize (environment, map_size_a));
 			assert (status3 == 0);
 			// It seems if there's ever more threads than mdb_env_set_maxreaders has read slots available, we get failures on transaction creation unless MDB_NOTLS is specified
 			// This can happen if something like 256 io_threads are specified in the node config
-			auto status4 (mdb_env_open (environment, path_a.string ().c_str (), MDB_NOSUBDIR | MDB_NOTLS, 00600));
+			auto status4 (mdb_env_open (environment, path_a.string ().c_str (), MDB_NOSUBDIR | MDB_NOTLS | (read_only_a ? MDB_RDONLY : 0), 00600));
 			error_a = status4 != 0;
 		}
 		else
@@ -120,7 +124,13 @@ environment (environment_a)
 
 raze::transaction::~transaction ()
 {
+	uint64_t id (mdb_txn_id (handle));
 	auto status (mdb_txn_commit (handle));
+	// Checked in release builds too, state tagged with the id, like the store caches, has to be dropped before the id is reused
+	if (status != 0)
+	{
+		environment.commit_failed (id);
+	}
 	assert (status == 0);
 }
 
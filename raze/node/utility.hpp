@@ -3,6 +3,7 @@
 #include <array>
 #include <atomic>
 #include <condition_variable>
+#include <functional>
 #include <type_traits>
 
 #include <boost/filesystem.hpp>
@@ -101,10 +102,12 @@ bool fetch_object (T & object, boost::filesystem::path const & path_a, std::fstr
 class mdb_env
 {
 public:
-	mdb_env (bool &, boost::filesystem::path const &, int max_dbs = 128);
+	mdb_env (bool &, boost::filesystem::path const &, int max_dbs = 128, size_t map_size = 1ULL * 1024 * 1024 * 1024 * 1024, bool read_only = false);
 	~mdb_env ();
 	operator MDB_env * () const;
 	MDB_env * environment;
+	// Called with the id of a transaction whose commit failed, LMDB hands the id out again to the next writer
+	std::function<void(uint64_t)> commit_failed;
 };
 class mdb_val
 {
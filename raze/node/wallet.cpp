@@ -744,10 +744,19 @@ bool raze::wallet::enter_password (std::string const & password_a)
 			this_l->search_pending ();
 		});
 	}
+	node.wallets.representatives_dirty = true;
 	lock_observer (result, password_a.empty ());
 	return result;
 }
 
+void raze::wallet::lock ()
+{
+	raze::raw_key empty;
+	empty.data.clear ();
+	store.password.value_set (empty);
+	node.wallets.representatives_dirty = true;
+}
+
 raze::public_key raze::wallet::deterministic_insert (MDB_txn * transaction_a, bool generate_work_a)
 {
 	raze::public_key key (0);
@@ -838,14 +847,15 @@ std::shared_ptr<raze::block> raze::wallet::receive_action (raze::send_block cons
 	std::shared_ptr<raze::block> block;
 	if (node.config.receive_minimum.number () <= amount_a.number ())
 	{
-		raze::transaction transaction (node.ledger.store.environment, nullptr, false);
-		if (node.ledger.store.pending_exists (transaction, raze::pending_key (send_a.hashables.destination, hash)))
+		raze::transaction block_transaction (node.ledger.store.environment, nullptr, false);
+		raze::transaction transaction (store.environment, nullptr, false);
+		if (node.ledger.store.pending_exists (block_transaction, raze::pending_key (send_a.hashables.destination, hash)))
 		{
 			raze::raw_key prv;
 			if (!store.fetch (transaction, send_a.hashables.destination, prv))
 			{
 				raze::account_info info;
-				auto new_account (node.ledger.store.account_get (transaction, send_a.hashables.destination, info));
+				auto new_account (node.ledger.store.account_get (block_transaction, send_a.hashables.destination, info));
 				if (!new_account)
 				{
 					auto receive (new raze::receive_block (info.head, hash, prv, send_a.hashables.destination, generate_work_a ? work_fetch (transaction, send_a.hashables.destination, info.head) : 0));
@@ -893,14 +903,15 @@ std::shared_ptr<raze::block> raze::wallet::change_action (raze::account const &
 {
 	std::shared_ptr<raze::block> block;
 	{
+		raze::transaction block_transaction (node.store.environment, nullptr, false);
 		raze::transaction transaction (store.environment, nullptr, false);
 		if (store.valid_password (transaction))
 		{
 			auto existing (store.find (transaction, source_a));
-			if (existing != store.end () && !node.ledger.latest (transaction, source_a).is_zero ())
+			if (existing != store.end () && !node.ledger.latest (block_transaction, source_a).is_zero ())
 			{
 				raze::account_info info;
-				auto error1 (node.ledger.store.account_get (transaction, source_a, info));
+				auto error1 (node.ledger.store.account_get (block_transaction, source_a, info));
 				assert (!error1);
 				raze::raw_key prv;
 				auto error2 (store.fetch (transaction, source_a, prv));
@@ -937,6 +948,7 @@ std::shared_ptr<raze::block> raze::wallet::send_action (raze::account const & so
 	bool error = false;
 	bool cached_block = false;
 	{
+		raze::transaction block_transaction (node.store.environment, nullptr, false);
 		raze::transaction transaction (store.environment, nullptr, (bool)id_mdb_val);
 		if (id_mdb_val)
 		{
@@ -945,11 +957,11 @@ std::shared_ptr<raze::block> raze::wallet::send_action (raze::account const & so
 			if (status == 0)
 			{
 				auto hash (result.uint256 ());
-				block = node.store.block_get (transaction, hash);
+				block = node.store.block_get (block_transaction, hash);
 				if (block != nullptr)
 				{
 					cached_block = true;
-					node.network.republish_block (transaction, block);
+					node.network.republish_block (block_transaction, block);
 				}
 			}
 			else if (status != MDB_NOTFOUND)
@@ -964,11 +976,11 @@ std::shared_ptr<raze::block> raze::wallet::send_action (raze::account const & so
 				auto existing (store.find (transaction, source_a));
 				if (existing != store.end ())
 				{
-					auto balance (node.ledger.account_balance (transaction, source_a));
+					auto balance (node.ledger.account_balance (block_transaction, source_a));
 					if (!balance.is_zero () && balance >= amount_a)
 					{
 						raze::account_info info;
-						auto error1 (node.ledger.store.account_get (transaction, source_a, info));
+						auto error1 (node.ledger.store.account_get (block_transaction, source_a, info));
 						assert (!error1);
 						raze::raw_key prv;
 						auto error2 (store.fetch (transaction, source_a, prv));
@@ -1063,7 +1075,11 @@ void raze::wallet::work_update (MDB_txn * transaction_a, raze::account const & a
 {
 	assert (!raze::work_validate (root_a, work_a));
 	assert (store.exists (transaction_a, account_a));
-	auto latest (node.ledger.latest_root (transaction_a, account_a));
+	raze::block_hash latest;
+	{
+		raze::transaction block_transaction (node.store.environment, nullptr, false);
+		latest = node.ledger.latest_root (block_transaction, account_a);
+	}
 	if (latest == root_a)
 	{
 		store.work_put (transaction_a, account_a, work_a);
@@ -1095,7 +1111,11 @@ uint64_t raze::wallet::work_fetch (MDB_txn * transaction_a, raze::account const
 void raze::wallet::work_ensure (MDB_txn * transaction_a, raze::account const & account_a)
 {
 	assert (store.exists (transaction_a, account_a));
-	auto root (node.ledger.latest_root (transaction_a, account_a));
+	raze::block_hash root;
+	{
+		raze::transaction block_transaction (node.store.environment, nullptr, false);
+		root = node.ledger.latest_root (block_transaction, account_a);
+	}
 	uint64_t work;
 	auto error (store.work_get (transaction_a, account_a, work));
 	assert (!error);
@@ -1124,15 +1144,23 @@ public:
 	void run ()
 	{
 		BOOST_LOG (wallet->node.log) << "Beginning pending block search";
+		auto ranges (raze::block_store::scan_ranges ());
+		std::vector<std::vector<std::pair<raze::pending_key, raze::pending_info>>> found (ranges);
+		wallet->node.store.parallel_scan (wallet->node.store.pending, ranges, [this, &found](size_t range_a, MDB_txn *, raze::mdb_val const & key_a, raze::mdb_val const & value_a) {
+			raze::pending_key key (key_a);
+			if (keys.find (key.account) != keys.end ())
+			{
+				found[range_a].push_back (std::make_pair (key, raze::pending_info (value_a)));
+			}
+		});
 		raze::transaction transaction (wallet->node.store.environment, nullptr, false);
 		std::unordered_set<raze::account> already_searched;
-		for (auto i (wallet->node.store.pending_begin (transaction)), n (wallet->node.store.pending_end ()); i != n; ++i)
+		for (auto & range : found)
 		{
-			raze::pending_key key (i->first);
-			raze::pending_info pending (i->second);
-			auto existing (keys.find (key.account));
-			if (existing != keys.end ())
+			for (auto & i : range)
 			{
+				auto & key (i.first);
+				auto & pending (i.second);
 				auto amount (pending.amount.number ());
 				if (wallet->node.config.receive_minimum.number () <= amount)
 				{
@@ -1146,7 +1174,7 @@ public:
 						auto this_l (shared_from_this ());
 						std::shared_ptr<raze::block> block_l (wallet->node.store.block_get (transaction, info.head));
 						wallet->node.background ([this_l, account, block_l] {
-							raze::transaction transaction (this_l->wallet->node.store.environment, nullptr, true);
+							raze::scheduled_transaction transaction (this_l->wallet->node.write_scheduler, raze::write_priority::consensus);
 							this_l->wallet->node.active.start (transaction, block_l, [this_l, account](std::shared_ptr<raze::block>, bool) {
 								// If there were any forks for this account they've been rolled back and we can receive anything remaining from this account
 								this_l->receive_all (account);
@@ -1168,16 +1196,17 @@ public:
 	{
 		BOOST_LOG (wallet->node.log) << boost::str (boost::format ("Account %1% confirmed, receiving all blocks") % account_a.to_account ());
 		raze::transaction transaction (wallet->node.store.environment, nullptr, false);
-		auto representative (wallet->store.representative (transaction));
+		raze::transaction wallet_transaction (wallet->store.environment, nullptr, false);
+		auto representative (wallet->store.representative (wallet_transaction));
 		for (auto i (wallet->node.store.pending_begin (transaction)), n (wallet->node.store.pending_end ()); i != n; ++i)
 		{
 			raze::pending_key key (i->first);
 			raze::pending_info pending (i->second);
 			if (pending.source == account_a)
 			{
-				if (wallet->store.exists (transaction, key.account))
+				if (wallet->store.exists (wallet_transaction, key.account))
 				{
-					if (wallet->store.valid_password (transaction))
+					if (wallet->store.valid_password (wallet_transaction))
 					{
 						raze::pending_key key (i->first);
 						std::shared_ptr<raze::block> block (wallet->node.store.block_get (transaction, key.hash));
@@ -1236,13 +1265,14 @@ raze::public_key raze::wallet::change_seed (MDB_txn * transaction_a, raze::raw_k
 {
 	store.seed_set (transaction_a, prv_a);
 	auto account = deterministic_insert (transaction_a);
+	raze::transaction block_transaction (node.store.environment, nullptr, false);
 	auto count (0);
 	for (uint32_t i (1), n (32); i < n; ++i)
 	{
 		raze::raw_key prv;
 		store.deterministic_key (prv, transaction_a, i);
 		raze::keypair pair (prv.data.to_string ());
-		auto latest (node.ledger.latest (transaction_a, pair.pub));
+		auto latest (node.ledger.latest (block_transaction, pair.pub));
 		if (!latest.is_zero ())
 		{
 			count = i;
@@ -1272,15 +1302,29 @@ void raze::wallet::work_generate (raze::account const & account_a, raze::block_h
 	}
 }
 
-raze::wallets::wallets (bool & error_a, raze::node & node_a) :
+raze::wallets::wallets (raze::node_init & init_a, raze::node & node_a, boost::filesystem::path const & path_a) :
 observer ([](bool) {}),
+environment (init_a.wallet_init, path_a, node_a.config.lmdb_max_dbs, 64ULL * 1024 * 1024 * 1024, node_a.config.read_only),
 node (node_a),
 stopped (false),
-thread ([this]() { do_wallet_actions (); })
+thread ([this]() { do_wallet_actions (); }),
+representatives_txnid (0),
+representatives_dirty (true)
 {
-	if (!error_a)
+	if (node_a.config.read_only && !boost::filesystem::exists (path_a))
+	{
+		// MDB_RDONLY can't create the file, a copied data.ldb or a data directory from before wallets moved out of data.ldb has none and that's an empty wallet set
+		init_a.wallet_init = false;
+	}
+	// Wallets belong to the node process that owns the ledger, a read only node opens its wallets.ldb MDB_RDONLY and never loads them
+	if (!init_a.error () && !node_a.config.read_only)
 	{
-		raze::transaction transaction (node.store.environment, nullptr, true);
+		{
+			raze::scheduled_transaction block_transaction (node.write_scheduler, raze::write_priority::normal);
+			raze::transaction transaction (environment, nullptr, true);
+			move_from_ledger (block_transaction, transaction);
+		}
+		raze::transaction transaction (environment, nullptr, true);
 		auto status (mdb_dbi_open (transaction, nullptr, MDB_CREATE, &handle));
 		status |= mdb_dbi_open (transaction, "send_action_ids", MDB_CREATE, &send_action_ids);
 		assert (status == 0);
@@ -1313,6 +1357,8 @@ raze::wallets::~wallets ()
 {
 	stop ();
 	thread.join ();
+	std::lock_guard<std::mutex> lock (representatives_mutex);
+	clear_representatives ();
 }
 
 std::shared_ptr<raze::wallet> raze::wallets::open (raze::uint256_union const & id_a)
@@ -1332,7 +1378,7 @@ std::shared_ptr<raze::wallet> raze::wallets::create (raze::uint256_union const &
 	std::shared_ptr<raze::wallet> result;
 	bool error;
 	{
-		raze::transaction transaction (node.store.environment, nullptr, true);
+		raze::transaction transaction (environment, nullptr, true);
 		result = std::make_shared<raze::wallet> (error, transaction, node, id_a.to_string ());
 	}
 	if (!error)
@@ -1368,7 +1414,7 @@ void raze::wallets::search_pending_all ()
 
 void raze::wallets::destroy (raze::uint256_union const & id_a)
 {
-	raze::transaction transaction (node.store.environment, nullptr, true);
+	raze::transaction transaction (environment, nullptr, true);
 	auto existing (items.find (id_a));
 	assert (existing != items.end ());
 	auto wallet (existing->second);
@@ -1408,20 +1454,40 @@ void raze::wallets::queue_wallet_action (raze::uint128_t const & amount_a, std::
 
 void raze::wallets::foreach_representative (MDB_txn * transaction_a, std::function<void(raze::public_key const & pub_a, raze::raw_key const & prv_a)> const & action_a)
 {
+	std::lock_guard<std::mutex> lock (representatives_mutex);
+	MDB_envinfo info;
+	mdb_env_info (environment, &info);
+	if (representatives_dirty.exchange (false) || info.me_last_txnid != representatives_txnid || representatives_refreshed + representatives_refresh < std::chrono::steady_clock::now ())
+	{
+		representatives_txnid = info.me_last_txnid;
+		refresh_representatives (transaction_a);
+	}
+	for (auto & i : representatives)
+	{
+		raze::raw_key prv;
+		prv.data = i.prv;
+		action_a (i.pub, prv);
+	}
+}
+
+void raze::wallets::refresh_representatives (MDB_txn * transaction_a)
+{
+	clear_representatives ();
+	representatives_refreshed = std::chrono::steady_clock::now ();
+	raze::transaction transaction (environment, nullptr, false);
+	std::vector<std::pair<std::shared_ptr<raze::wallet>, raze::representative_key>> found;
 	for (auto i (items.begin ()), n (items.end ()); i != n; ++i)
 	{
 		auto & wallet (*i->second);
-		for (auto j (wallet.store.begin (transaction_a)), m (wallet.store.end ()); j != m; ++j)
+		for (auto j (wallet.store.begin (transaction)), m (wallet.store.end ()); j != m; ++j)
 		{
 			raze::account account (j->first.uint256 ());
-			if (!node.ledger.weight (transaction_a, account).is_zero ())
+			auto weight (node.ledger.weight (transaction_a, account));
+			if (!weight.is_zero ())
 			{
-				if (wallet.store.valid_password (transaction_a))
+				if (wallet.store.valid_password (transaction))
 				{
-					raze::raw_key prv;
-					auto error (wallet.store.fetch (transaction_a, j->first.uint256 (), prv));
-					assert (!error);
-					action_a (j->first.uint256 (), prv);
+					found.push_back (std::make_pair (i->second, raze::representative_key{ account, 0 }));
 				}
 				else
 				{
@@ -1435,18 +1501,92 @@ void raze::wallets::foreach_representative (MDB_txn * transaction_a, std::functi
 			}
 		}
 	}
+	// Sized up front so decrypted keys are never left behind by a reallocation
+	representatives.reserve (found.size ());
+	if (!found.empty ())
+	{
+		raze::memory_lock (representatives.data (), representatives.capacity () * sizeof (raze::representative_key));
+	}
+	for (auto & i : found)
+	{
+		raze::raw_key prv;
+		auto error (i.first->store.fetch (transaction, i.second.pub, prv));
+		assert (!error);
+		representatives.push_back (i.second);
+		representatives.back ().prv = prv.data;
+	}
 }
 
-bool raze::wallets::exists (MDB_txn * transaction_a, raze::public_key const & account_a)
+void raze::wallets::clear_representatives ()
 {
+	for (auto & i : representatives)
+	{
+		i.prv.clear ();
+	}
+	if (representatives.capacity () != 0)
+	{
+		raze::memory_unlock (representatives.data (), representatives.capacity () * sizeof (raze::representative_key));
+	}
+	std::vector<raze::representative_key> empty;
+	representatives.swap (empty);
+}
+
+bool raze::wallets::exists (raze::public_key const & account_a)
+{
+	raze::transaction transaction (environment, nullptr, false);
 	auto result (false);
 	for (auto i (items.begin ()), n (items.end ()); !result && i != n; ++i)
 	{
-		result = i->second->store.exists (transaction_a, account_a);
+		result = i->second->store.exists (transaction, account_a);
 	}
 	return result;
 }
 
+// Wallets used to be stored in the ledger environment, copy any found there in to ours and drop them from the ledger
+void raze::wallets::move_from_ledger (MDB_txn * block_transaction_a, MDB_txn * transaction_a)
+{
+	MDB_dbi ledger_handle;
+	auto status (mdb_dbi_open (block_transaction_a, nullptr, 0, &ledger_handle));
+	assert (status == 0);
+	std::vector<std::string> tables;
+	std::string beginning (raze::uint256_union (0).to_string ());
+	std::string end ((raze::uint256_union (raze::uint256_t (0) - raze::uint256_t (1))).to_string ());
+	for (raze::store_iterator i (block_transaction_a, ledger_handle, raze::mdb_val (beginning.size (), const_cast<char *> (beginning.c_str ()))), n (block_transaction_a, ledger_handle, raze::mdb_val (end.size (), const_cast<char *> (end.c_str ()))); i != n; ++i)
+	{
+		tables.push_back (std::string (reinterpret_cast<char const *> (i->first.data ()), i->first.size ()));
+	}
+	auto wallet_count (tables.size ());
+	tables.push_back ("send_action_ids");
+	for (auto i (tables.begin ()), n (tables.end ()); i != n; ++i)
+	{
+		MDB_dbi source;
+		auto status1 (mdb_dbi_open (block_transaction_a, i->c_str (), 0, &source));
+		if (status1 == 0)
+		{
+			MDB_dbi destination;
+			auto status2 (mdb_dbi_open (transaction_a, i->c_str (), MDB_CREATE, &destination));
+			assert (status2 == 0);
+			{
+				for (raze::store_iterator j (block_transaction_a, source), m (nullptr); j != m; ++j)
+				{
+					auto status3 (mdb_put (transaction_a, destination, j->first, j->second, 0));
+					assert (status3 == 0);
+				}
+			}
+			auto status4 (mdb_drop (block_transaction_a, source, 1));
+			assert (status4 == 0);
+		}
+		else
+		{
+			assert (status1 == MDB_NOTFOUND);
+		}
+	}
+	if (wallet_count > 0)
+	{
+		BOOST_LOG (node.log) << boost::str (boost::format ("Moved %1% wallets out of the ledger") % wallet_count);
+	}
+}
+
 void raze::wallets::stop ()
 {
 	std::lock_guard<std::mutex> lock (mutex);
@@ -1455,6 +1595,7 @@ void raze::wallets::stop ()
 }
 
 raze::uint128_t const raze::wallets::generate_priority = std::numeric_limits<raze::uint128_t>::max ();
+std::chrono::seconds constexpr raze::wallets::representatives_refresh;
 raze::uint128_t const raze::wallets::high_priority = std::numeric_limits<raze::uint128_t>::max () - 1;
 
 raze::store_iterator raze::wallet_store::begin (MDB_txn * transaction_a)
@@ -117,6 +117,7 @@ public:
 	std::recursive_mutex mutex;
 };
 class node;
+class node_init;
 // A wallet is a set of account keys encrypted by a common encryption key
 class wallet : public std::enable_shared_from_this<raze::wallet>
 {
@@ -129,6 +130,8 @@ public:
 	void enter_initial_password ();
 	bool valid_password ();
 	bool enter_password (std::string const &);
+	// Forget the password and drop any cached representative keys of this wallet
+	void lock ();
 	raze::public_key insert_adhoc (raze::raw_key const &, bool = true);
 	raze::public_key insert_adhoc (MDB_txn *, raze::raw_key const &, bool = true);
 	raze::public_key deterministic_insert (MDB_txn *, bool = true);
@@ -155,11 +158,18 @@ public:
 	raze::wallet_store store;
 	raze::node & node;
 };
+// Decrypted key of a local representative with voting weight
+class representative_key
+{
+public:
+	raze::public_key pub;
+	raze::uint256_union prv;
+};
 // The wallets set is all the wallets a node controls.  A node may contain multiple wallets independently encrypted and operated.
 class wallets
 {
 public:
-	wallets (bool &, raze::node &);
+	wallets (raze::node_init &, raze::node &, boost::filesystem::path const &);
 	~wallets ();
 	std::shared_ptr<raze::wallet> open (raze::uint256_union const &);
 	std::shared_ptr<raze::wallet> create (raze::uint256_union const &);
@@ -168,8 +178,13 @@ public:
 	void destroy (raze::uint256_union const &);
 	void do_wallet_actions ();
 	void queue_wallet_action (raze::uint128_t const &, std::function<void()> const &);
+	// Calls action for every unlocked key with voting weight in the ledger transaction
 	void foreach_representative (MDB_txn *, std::function<void(raze::public_key const &, raze::raw_key const &)> const &);
-	bool exists (MDB_txn *, raze::public_key const &);
+	// Decrypt the keys of unlocked representatives with weight into memory locked out of swap
+	void refresh_representatives (MDB_txn *);
+	void clear_representatives ();
+	bool exists (raze::public_key const &);
+	void move_from_ledger (MDB_txn *, MDB_txn *);
 	void stop ();
 	std::function<void(bool)> observer;
 	std::unordered_map<raze::uint256_union, std::shared_ptr<raze::wallet>> items;
@@ -177,12 +192,21 @@ public:
 	std::mutex mutex;
 	std::condition_variable condition;
 	raze::kdf kdf;
+	// Wallets live in their own environment so they don't contend with the ledger for the writer lock or sync behind its commits
+	raze::mdb_env environment;
 	MDB_dbi handle;
 	MDB_dbi send_action_ids;
 	raze::node & node;
 	bool stopped;
 	std::thread thread;
+	// Representative keys are cached until the wallet environment is written to, a wallet is locked or unlocked, or the refresh interval passes so weight changes are noticed
+	std::mutex representatives_mutex;
+	std::vector<raze::representative_key> representatives;
+	size_t representatives_txnid;
+	std::chrono::steady_clock::time_point representatives_refreshed;
+	std::atomic<bool> representatives_dirty;
 	static raze::uint128_t const generate_priority;
 	static raze::uint128_t const high_priority;
+	static std::chrono::seconds constexpr representatives_refresh = std::chrono::seconds (60);
 };
 }
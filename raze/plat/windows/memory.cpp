@@ -0,0 +1,15 @@
+#include <raze/lib/utility.hpp>
+
+#include <windows.h>
+
+void raze::memory_lock (void * address_a, size_t size_a)
+{
+	auto result (VirtualLock (address_a, size_a));
+	(void)result;
+}
+
+void raze::memory_unlock (void * address_a, size_t size_a)
+{
+	auto result (VirtualUnlock (address_a, size_a));
+	(void)result;
+}
@@ -244,14 +244,15 @@ wallet (wallet_a)
 
 void raze_qt::accounts::refresh_wallet_balance ()
 {
+	raze::transaction block_transaction (this->wallet.node.store.environment, nullptr, false);
 	raze::transaction transaction (this->wallet.wallet_m->store.environment, nullptr, false);
 	raze::uint128_t balance (0);
 	raze::uint128_t pending (0);
 	for (auto i (this->wallet.wallet_m->store.begin (transaction)), j (this->wallet.wallet_m->store.end ()); i != j; ++i)
 	{
 		raze::public_key key (i->first.uint256 ());
-		balance = balance + (this->wallet.node.ledger.account_balance (transaction, key));
-		pending = pending + (this->wallet.node.ledger.account_pending (transaction, key));
+		balance = balance + (this->wallet.node.ledger.account_balance (block_transaction, key));
+		pending = pending + (this->wallet.node.ledger.account_pending (block_transaction, key));
 	}
 	auto final_text (std::string ("Balance: ") + wallet.format_balance (balance));
 	if (!pending.is_zero ())
@@ -269,12 +270,13 @@ void raze_qt::accounts::refresh_wallet_balance ()
 void raze_qt::accounts::refresh ()
 {
 	model->removeRows (0, model->rowCount ());
+	raze::transaction block_transaction (wallet.node.store.environment, nullptr, false);
 	raze::transaction transaction (wallet.wallet_m->store.environment, nullptr, false);
 	QBrush brush;
 	for (auto i (wallet.wallet_m->store.begin (transaction)), j (wallet.wallet_m->store.end ()); i != j; ++i)
 	{
 		raze::public_key key (i->first.uint256 ());
-		auto balance_amount (wallet.node.ledger.account_balance (transaction, key));
+		auto balance_amount (wallet.node.ledger.account_balance (block_transaction, key));
 		bool display (true);
 		switch (wallet.wallet_m->store.key_type (i->second))
 		{
@@ -1416,9 +1418,7 @@ wallet (wallet_a)
 		if (this->wallet.wallet_m->store.valid_password (transaction))
 		{
 			// lock wallet
-			raze::raw_key empty;
-			empty.data.clear ();
-			this->wallet.wallet_m->store.password.value_set (empty);
+			this->wallet.wallet_m->lock ();
 			update_locked (true, true);
 			lock_toggle->setText ("Unlock");
 			password->setEnabled (1);
@@ -1479,7 +1479,8 @@ void raze_qt::settings::refresh_representative ()
 	}
 	else
 	{
-		current_representative->setText (this->wallet.wallet_m->store.representative (transaction).to_account_split ().c_str ());
+		raze::transaction wallet_transaction (this->wallet.wallet_m->store.environment, nullptr, false);
+		current_representative->setText (this->wallet.wallet_m->store.representative (wallet_transaction).to_account_split ().c_str ());
 	}
 }
 
@@ -1705,19 +1706,28 @@ void raze_qt::advanced_actions::refresh_peers ()
 void raze_qt::advanced_actions::refresh_ledger ()
 {
 	ledger_model->removeRows (0, ledger_model->rowCount ());
-	raze::transaction transaction (wallet.node.store.environment, nullptr, false);
-	for (auto i (wallet.node.ledger.store.latest_begin (transaction)), j (wallet.node.ledger.store.latest_end ()); i != j; ++i)
+	// Format rows across the scan threads, items have to be created on the GUI thread
+	auto ranges (raze::block_store::scan_ranges ());
+	std::vector<std::vector<std::array<std::string, 3>>> rows (ranges);
+	wallet.node.store.parallel_scan (wallet.node.store.accounts, ranges, [this, &rows](size_t range_a, MDB_txn *, raze::mdb_val const & key_a, raze::mdb_val const & value_a) {
+		std::array<std::string, 3> row;
+		row[0] = raze::account (key_a.uint256 ()).to_account ();
+		raze::account_info info (value_a);
+		raze::amount (info.balance.number () / wallet.rendering_ratio).encode_dec (row[1]);
+		info.head.encode_hex (row[2]);
+		rows[range_a].push_back (row);
+	});
+	for (auto & i : rows)
 	{
-		QList<QStandardItem *> items;
-		items.push_back (new QStandardItem (QString (raze::block_hash (i->first.uint256 ()).to_account ().c_str ())));
-		raze::account_info info (i->second);
-		std::string balance;
-		raze::amount (info.balance.number () / wallet.rendering_ratio).encode_dec (balance);
-		items.push_back (new QStandardItem (QString (balance.c_str ())));
-		std::string block_hash;
-		info.head.encode_hex (block_hash);
-		items.push_back (new QStandardItem (QString (block_hash.c_str ())));
-		ledger_model->appendRow (items);
+		for (auto & j : i)
+		{
+			QList<QStandardItem *> items;
+			for (auto & k : j)
+			{
+				items.push_back (new QStandardItem (QString (k.c_str ())));
+			}
+			ledger_model->appendRow (items);
+		}
 	}
 }
 
@@ -1936,8 +1946,9 @@ void raze_qt::block_creation::create_send ()
 			if (!error)
 			{
 				raze::transaction transaction (wallet.node.store.environment, nullptr, false);
+				raze::transaction wallet_transaction (wallet.wallet_m->store.environment, nullptr, false);
 				raze::raw_key key;
-				if (!wallet.wallet_m->store.fetch (transaction, account_l, key))
+				if (!wallet.wallet_m->store.fetch (wallet_transaction, account_l, key))
 				{
 					auto balance (wallet.node.ledger.account_balance (transaction, account_l));
 					if (amount_l.number () <= balance)
@@ -1945,7 +1956,7 @@ void raze_qt::block_creation::create_send ()
 						raze::account_info info;
 						auto error (wallet.node.store.account_get (transaction, account_l, info));
 						assert (!error);
-						raze::send_block send (info.head, destination_l, balance - amount_l.number (), key, account_l, wallet.wallet_m->work_fetch (transaction, account_l, info.head));
+						raze::send_block send (info.head, destination_l, balance - amount_l.number (), key, account_l, wallet.wallet_m->work_fetch (wallet_transaction, account_l, info.head));
 						std::string block_l;
 						send.serialize_json (block_l);
 						block->setPlainText (QString (block_l.c_str ()));
@@ -1990,6 +2001,7 @@ void raze_qt::block_creation::create_receive ()
 	if (!error)
 	{
 		raze::transaction transaction (wallet.node.store.environment, nullptr, false);
+		raze::transaction wallet_transaction (wallet.wallet_m->store.environment, nullptr, false);
 		auto block_l (wallet.node.store.block_get (transaction, source_l));
 		if (block_l != nullptr)
 		{
@@ -2005,10 +2017,10 @@ void raze_qt::block_creation::create_receive ()
 					if (!error)
 					{
 						raze::raw_key key;
-						auto error (wallet.wallet_m->store.fetch (transaction, pending_key.account, key));
+						auto error (wallet.wallet_m->store.fetch (wallet_transaction, pending_key.account, key));
 						if (!error)
 						{
-							raze::receive_block receive (info.head, source_l, key, pending_key.account, wallet.wallet_m->work_fetch (transaction, pending_key.account, info.head));
+							raze::receive_block receive (info.head, source_l, key, pending_key.account, wallet.wallet_m->work_fetch (wallet_transaction, pending_key.account, info.head));
 							std::string block_l;
 							receive.serialize_json (block_l);
 							block->setPlainText (QString (block_l.c_str ()));
@@ -2063,15 +2075,16 @@ void raze_qt::block_creation::create_change ()
 		if (!error)
 		{
 			raze::transaction transaction (wallet.node.store.environment, nullptr, false);
+			raze::transaction wallet_transaction (wallet.wallet_m->store.environment, nullptr, false);
 			raze::account_info info;
 			auto error (wallet.node.store.account_get (transaction, account_l, info));
 			if (!error)
 			{
 				raze::raw_key key;
-				auto error (wallet.wallet_m->store.fetch (transaction, account_l, key));
+				auto error (wallet.wallet_m->store.fetch (wallet_transaction, account_l, key));
 				if (!error)
 				{
-					raze::change_block change (info.head, representative_l, key, account_l, wallet.wallet_m->work_fetch (transaction, account_l, info.head));
+					raze::change_block change (info.head, representative_l, key, account_l, wallet.wallet_m->work_fetch (wallet_transaction, account_l, info.head));
 					std::string block_l;
 					change.serialize_json (block_l);
 					block->setPlainText (QString (block_l.c_str ()));
@@ -2114,6 +2127,7 @@ void raze_qt::block_creation::create_open ()
 		if (!error)
 		{
 			raze::transaction transaction (wallet.node.store.environment, nullptr, false);
+			raze::transaction wallet_transaction (wallet.wallet_m->store.environment, nullptr, false);
 			auto block_l (wallet.node.store.block_get (transaction, source_l));
 			if (block_l != nullptr)
 			{
@@ -2129,10 +2143,10 @@ void raze_qt::block_creation::create_open ()
 						if (error)
 						{
 							raze::raw_key key;
-							auto error (wallet.wallet_m->store.fetch (transaction, pending_key.account, key));
+							auto error (wallet.wallet_m->store.fetch (wallet_transaction, pending_key.account, key));
 							if (!error)
 							{
-								raze::open_block open (source_l, representative_l, pending_key.account, key, pending_key.account, wallet.wallet_m->work_fetch (transaction, pending_key.account, pending_key.account));
+								raze::open_block open (source_l, representative_l, pending_key.account, key, pending_key.account, wallet.wallet_m->work_fetch (wallet_transaction, pending_key.account, pending_key.account));
 								std::string block_l;
 								open.serialize_json (block_l);
 								block->setPlainText (QString (block_l.c_str ()));
@@ -1,12 +1,14 @@
 #include <raze/secure.hpp>
 
 #include <raze/lib/interface.h>
+#include <raze/lib/work.hpp>
 #include <raze/node/common.hpp>
 #include <raze/node/working.hpp>
 #include <raze/versioning.hpp>
 
 #include <boost/property_tree/json_parser.hpp>
 
+#include <numeric>
 #include <queue>
 
 #include <ed25519-donna/ed25519.h>
@@ -89,6 +91,7 @@ size_t constexpr raze::send_block::size;
 size_t constexpr raze::receive_block::size;
 size_t constexpr raze::open_block::size;
 size_t constexpr raze::change_block::size;
+size_t constexpr raze::vote::max_hashes;
 
 raze::keypair const & raze::zero_key (globals.zero_key);
 raze::keypair const & raze::test_genesis_key (globals.test_genesis_key);
@@ -455,8 +458,13 @@ size_t raze::block_counts::sum ()
 	return send + receive + open + change;
 }
 
-raze::block_store::block_store (bool & error_a, boost::filesystem::path const & path_a, int lmdb_max_dbs) :
-environment (error_a, path_a, lmdb_max_dbs),
+raze::block_store::block_store (bool & error_a, boost::filesystem::path const & path_a, int lmdb_max_dbs, bool read_only_a) :
+blocks_cache (block_cache_max),
+account_cache (account_cache_max),
+write_buffer (nullptr),
+scan_threads (0),
+read_only (read_only_a),
+environment (error_a, path_a, lmdb_max_dbs, 1ULL * 1024 * 1024 * 1024 * 1024, read_only_a),
 frontiers (0),
 accounts (0),
 send_blocks (0),
@@ -464,33 +472,57 @@ receive_blocks (0),
 open_blocks (0),
 change_blocks (0),
 pending (0),
+successors (0),
 blocks_info (0),
+block_heights (0),
+account_heights (0),
+confirmation_height (0),
 representation (0),
 unchecked (0),
 unsynced (0),
 checksum (0)
 {
+	// Entries a failed transaction wrote are tagged with an id the next writer reuses
+	environment.commit_failed = [this](uint64_t id_a) {
+		blocks_cache.clear (id_a);
+		account_cache.clear (id_a);
+	};
 	if (!error_a)
 	{
-		raze::transaction transaction (environment, nullptr, true);
-		error_a |= mdb_dbi_open (transaction, "frontiers", MDB_CREATE, &frontiers) != 0;
-		error_a |= mdb_dbi_open (transaction, "accounts", MDB_CREATE, &accounts) != 0;
-		error_a |= mdb_dbi_open (transaction, "send", MDB_CREATE, &send_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "receive", MDB_CREATE, &receive_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "open", MDB_CREATE, &open_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "change", MDB_CREATE, &change_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "pending", MDB_CREATE, &pending) != 0;
-		error_a |= mdb_dbi_open (transaction, "blocks_info", MDB_CREATE, &blocks_info) != 0;
-		error_a |= mdb_dbi_open (transaction, "representation", MDB_CREATE, &representation) != 0;
-		error_a |= mdb_dbi_open (transaction, "unchecked", MDB_CREATE | MDB_DUPSORT, &unchecked) != 0;
-		error_a |= mdb_dbi_open (transaction, "unsynced", MDB_CREATE, &unsynced) != 0;
-		error_a |= mdb_dbi_open (transaction, "checksum", MDB_CREATE, &checksum) != 0;
-		error_a |= mdb_dbi_open (transaction, "vote", MDB_CREATE, &vote) != 0;
-		error_a |= mdb_dbi_open (transaction, "meta", MDB_CREATE, &meta) != 0;
-		if (!error_a)
+		// A read only store can only open tables that already exist
+		unsigned create (read_only ? 0 : MDB_CREATE);
+		raze::transaction transaction (environment, nullptr, !read_only);
+		error_a |= mdb_dbi_open (transaction, "frontiers", create, &frontiers) != 0;
+		error_a |= mdb_dbi_open (transaction, "accounts", create, &accounts) != 0;
+		error_a |= mdb_dbi_open (transaction, "send", create, &send_blocks) != 0;
+		error_a |= mdb_dbi_open (transaction, "receive", create, &receive_blocks) != 0;
+		error_a |= mdb_dbi_open (transaction, "open", create, &open_blocks) != 0;
+		error_a |= mdb_dbi_open (transaction, "change", create, &change_blocks) != 0;
+		error_a |= mdb_dbi_open (transaction, "pending", create, &pending) != 0;
+		error_a |= mdb_dbi_open (transaction, "successors", create, &successors) != 0;
+		error_a |= mdb_dbi_open (transaction, "blocks_info", create, &blocks_info) != 0;
+		error_a |= mdb_dbi_open (transaction, "block_heights", create, &block_heights) != 0;
+		error_a |= mdb_dbi_open (transaction, "account_heights", create, &account_heights) != 0;
+		error_a |= mdb_dbi_open (transaction, "confirmation_height", create, &confirmation_height) != 0;
+		error_a |= mdb_dbi_open (transaction, "representation", create, &representation) != 0;
+		error_a |= mdb_dbi_open (transaction, "unchecked", create | MDB_DUPSORT, &unchecked) != 0;
+		error_a |= mdb_dbi_open (transaction, "unsynced", create, &unsynced) != 0;
+		error_a |= mdb_dbi_open (transaction, "checksum", create, &checksum) != 0;
+		error_a |= mdb_dbi_open (transaction, "vote", create, &vote) != 0;
+		error_a |= mdb_dbi_open (transaction, "meta", create, &meta) != 0;
+		if (read_only)
+		{
+			// Upgrades are left to the process that owns the store
+			error_a |= !error_a && version_get (transaction) != version_current;
+		}
+		else if (!error_a)
 		{
 			do_upgrades (transaction);
-			checksum_put (transaction, 0, 0, 0);
+			raze::checksum existing;
+			if (checksum_get (transaction, 0, 0, existing))
+			{
+				checksum_put (transaction, 0, 0, 0);
+			}
 		}
 	}
 }
@@ -545,6 +577,14 @@ void raze::block_store::do_upgrades (MDB_txn * transaction_a)
 		case 9:
 			upgrade_v9_to_v10 (transaction_a);
 		case 10:
+			upgrade_v10_to_v11 (transaction_a);
+		case 11:
+			upgrade_v11_to_v12 (transaction_a);
+		case 12:
+			upgrade_v12_to_v13 (transaction_a);
+		case 13:
+			upgrade_v13_to_v14 (transaction_a);
+		case 14:
 			break;
 		default:
 			assert (false);
@@ -675,10 +715,10 @@ void raze::block_store::upgrade_v4_to_v5 (MDB_txn * transaction_a)
 		while (block != nullptr)
 		{
 			auto hash (block->hash ());
-			if (block_successor (transaction_a, hash).is_zero () && !successor.is_zero ())
+			if (block_successor_v11 (transaction_a, hash).is_zero () && !successor.is_zero ())
 			{
 				//std::cerr << boost::str (boost::format ("Adding successor for account %1%, block %2%, successor %3%\n") % account.to_account () % hash.to_string () % successor.to_string ());
-				block_put (transaction_a, hash, *block, successor);
+				block_put_v11 (transaction_a, hash, *block, successor);
 			}
 			successor = hash;
 			block = block_get (transaction_a, block->previous ());
@@ -775,7 +815,7 @@ void raze::block_store::upgrade_v9_to_v10 (MDB_txn * transaction_a)
 					block_info.balance = balance;
 					block_info_put (transaction_a, hash, block_info);
 				}
-				hash = block_successor (transaction_a, hash);
+				hash = block_successor_v11 (transaction_a, hash);
 				++block_count;
 			}
 		}
@@ -783,54 +823,175 @@ void raze::block_store::upgrade_v9_to_v10 (MDB_txn * transaction_a)
 	//std::cerr << boost::str (boost::format ("Database upgrade is completed\n"));
 }
 
-void raze::block_store::clear (MDB_dbi db_a)
+void raze::block_store::upgrade_v10_to_v11 (MDB_txn * transaction_a)
 {
-	raze::transaction transaction (environment, nullptr, true);
-	auto status (mdb_drop (transaction, db_a, 0));
-	assert (status == 0);
+	version_put (transaction_a, 11);
+	mdb_drop (transaction_a, block_heights, 0);
+	mdb_drop (transaction_a, account_heights, 0);
+	for (auto i (latest_begin (transaction_a)), n (latest_end ()); i != n; ++i)
+	{
+		raze::account account (i->first.uint256 ());
+		raze::account_info info (i->second);
+		uint64_t height (1);
+		auto hash (info.open_block);
+		while (!hash.is_zero ())
+		{
+			block_height_put (transaction_a, account, height, hash);
+			hash = block_successor_v11 (transaction_a, hash);
+			++height;
+		}
+		assert (height == info.block_count + 1);
+	}
 }
 
-namespace
+void raze::block_store::upgrade_v11_to_v12 (MDB_txn * transaction_a)
 {
-// Fill in our predecessors
-class set_predecessor : public raze::block_visitor
+	version_put (transaction_a, 12);
+	mdb_drop (transaction_a, successors, 0);
+	for (auto type : { raze::block_type::send, raze::block_type::receive, raze::block_type::open, raze::block_type::change })
+	{
+		for (raze::store_iterator i (transaction_a, block_database (type)), n (nullptr); i != n; ++i)
+		{
+			raze::block_hash hash (i->first.uint256 ());
+			raze::block_hash successor;
+			assert (i->second.size () > successor.bytes.size ());
+			auto data (reinterpret_cast<uint8_t const *> (i->second.data ()));
+			auto size (i->second.size () - successor.bytes.size ());
+			std::copy (data + size, data + size + successor.bytes.size (), successor.bytes.begin ());
+			if (!successor.is_zero ())
+			{
+				auto status1 (mdb_put (transaction_a, successors, raze::mdb_val (hash), raze::mdb_val (successor), 0));
+				assert (status1 == 0);
+			}
+			std::vector<uint8_t> vector (data, data + size);
+			auto status2 (mdb_cursor_put (i.cursor, raze::mdb_val (hash), raze::mdb_val (vector.size (), vector.data ()), MDB_CURRENT));
+			assert (status2 == 0);
+		}
+	}
+}
+
+void raze::block_store::upgrade_v12_to_v13 (MDB_txn * transaction_a)
 {
-public:
-	set_predecessor (MDB_txn * transaction_a, raze::block_store & store_a) :
-	transaction (transaction_a),
-	store (store_a)
+	version_put (transaction_a, 13);
+	// The checksum was reset every time the store was opened, rebuild it from the account heads
+	raze::checksum value (0);
+	for (auto i (latest_begin (transaction_a)), n (latest_end ()); i != n; ++i)
 	{
+		raze::account_info info (i->second);
+		value ^= info.head;
 	}
-	virtual ~set_predecessor () = default;
-	void fill_value (raze::block const & block_a)
+	checksum_put (transaction_a, 0, 0, value);
+}
+
+void raze::block_store::upgrade_v13_to_v14 (MDB_txn * transaction_a)
+{
+	version_put (transaction_a, 14);
+	// Nothing was tracked before, only the genesis block is known to be confirmed
+	raze::genesis genesis;
+	uint64_t height;
+	if (!block_height_get (transaction_a, genesis.hash (), height))
 	{
-		auto hash (block_a.hash ());
-		raze::block_type type;
-		auto value (store.block_get_raw (transaction, block_a.previous (), type));
-		assert (value.mv_size != 0);
-		std::vector<uint8_t> data (static_cast<uint8_t *> (value.mv_data), static_cast<uint8_t *> (value.mv_data) + value.mv_size);
-		std::copy (hash.bytes.begin (), hash.bytes.end (), data.end () - hash.bytes.size ());
-		store.block_put_raw (transaction, store.block_database (type), block_a.previous (), raze::mdb_val (data.size (), data.data ()));
+		confirmation_height_put (transaction_a, raze::genesis_account, height);
 	}
-	void send_block (raze::send_block const & block_a) override
+}
+
+void raze::block_store::block_put_v11 (MDB_txn * transaction_a, raze::block_hash const & hash_a, raze::block const & block_a, raze::block_hash const & successor_a)
+{
+	std::vector<uint8_t> vector;
 	{
-		fill_value (block_a);
+		raze::vectorstream stream (vector);
+		block_a.serialize (stream);
+		raze::write (stream, successor_a.bytes);
 	}
-	void receive_block (raze::receive_block const & block_a) override
+	block_put_raw (transaction_a, block_database (block_a.type ()), hash_a, { vector.size (), vector.data () });
+}
+
+raze::block_hash raze::block_store::block_successor_v11 (MDB_txn * transaction_a, raze::block_hash const & hash_a)
+{
+	raze::block_type type;
+	auto value (block_get_raw (transaction_a, hash_a, type));
+	raze::block_hash result;
+	if (value.mv_size != 0)
 	{
-		fill_value (block_a);
+		assert (value.mv_size >= result.bytes.size ());
+		raze::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data) + value.mv_size - result.bytes.size (), result.bytes.size ());
+		auto error (raze::read (stream, result.bytes));
+		assert (!error);
 	}
-	void open_block (raze::open_block const & block_a) override
+	else
+	{
+		result.clear ();
+	}
+	return result;
+}
+
+void raze::block_store::parallel_scan (MDB_dbi table_a, size_t ranges_a, std::function<void(size_t, MDB_txn *, raze::mdb_val const &, raze::mdb_val const &)> const & action_a)
+{
+	assert (ranges_a > 0);
+	raze::uint256_t span (std::numeric_limits<raze::uint256_t>::max () / ranges_a);
+	// Ranges are handed out as threads free up so however many workers we get, every range is scanned
+	std::atomic<size_t> next (0);
+	auto scan ([this, table_a, ranges_a, &action_a, &span, &next]() {
+		raze::transaction transaction (environment, nullptr, false);
+		for (auto i (next++); i < ranges_a; i = next++)
+		{
+			raze::uint256_union begin (span * i);
+			auto last (i + 1 == ranges_a);
+			raze::uint256_union end (last ? raze::uint256_t (0) : span * (i + 1));
+			for (raze::store_iterator j (transaction, table_a, raze::mdb_val (begin)), n (nullptr); j != n && (last || std::memcmp (j->first.data (), end.bytes.data (), end.bytes.size ()) < 0); ++j)
+			{
+				assert (j->first.size () >= end.bytes.size ());
+				action_a (i, transaction, j->first, j->second);
+			}
+		}
+	});
+	size_t workers (0);
 	{
-		// Open blocks don't have a predecessor
+		raze::transaction transaction (environment, nullptr, false);
+		MDB_stat stats;
+		auto status (mdb_stat (transaction, table_a, &stats));
+		assert (status == 0);
+		if (stats.ms_entries > scan_sequential_max)
+		{
+			std::lock_guard<std::mutex> lock (scan_mutex);
+			auto available (scan_ranges () > scan_threads ? scan_ranges () - scan_threads : 0);
+			workers = std::min (ranges_a - 1, available);
+			scan_threads += workers;
+		}
 	}
-	void change_block (raze::change_block const & block_a) override
+	std::vector<std::thread> threads;
+	for (size_t i (0); i < workers; ++i)
 	{
-		fill_value (block_a);
+		threads.push_back (std::thread (scan));
+	}
+	scan ();
+	for (auto & i : threads)
+	{
+		i.join ();
+	}
+	if (workers > 0)
+	{
+		std::lock_guard<std::mutex> lock (scan_mutex);
+		scan_threads -= workers;
+	}
+}
+
+size_t const raze::block_store::scan_sequential_max;
+
+size_t raze::block_store::scan_ranges ()
+{
+	return std::max<size_t> (1, std::thread::hardware_concurrency ());
+}
+
+void raze::block_store::clear (MDB_dbi db_a)
+{
+	raze::transaction transaction (environment, nullptr, true);
+	auto status (mdb_drop (transaction, db_a, 0));
+	assert (status == 0);
+	if (db_a == accounts)
+	{
+		account_cache.clear (transaction);
 	}
-	MDB_txn * transaction;
-	raze::block_store & store;
-};
 }
 
 MDB_dbi raze::block_store::block_database (raze::block_type type_a)
@@ -870,11 +1031,23 @@ void raze::block_store::block_put (MDB_txn * transaction_a, raze::block_hash con
 	{
 		raze::vectorstream stream (vector);
 		block_a.serialize (stream);
-		raze::write (stream, successor_a.bytes);
 	}
 	block_put_raw (transaction_a, block_database (block_a.type ()), hash_a, { vector.size (), vector.data () });
-	set_predecessor predecessor (transaction_a, *this);
-	block_a.visit (predecessor);
+	{
+		raze::bufferstream stream (vector.data (), vector.size ());
+		blocks_cache.put (transaction_a, hash_a, raze::deserialize_block (stream, block_a.type ()));
+	}
+	if (!successor_a.is_zero ())
+	{
+		auto status1 (mdb_put (transaction_a, successors, raze::mdb_val (hash_a), raze::mdb_val (successor_a), 0));
+		assert (status1 == 0);
+	}
+	// Open blocks don't have a predecessor
+	if (!block_a.previous ().is_zero ())
+	{
+		auto status2 (mdb_put (transaction_a, successors, raze::mdb_val (block_a.previous ()), raze::mdb_val (hash_a), 0));
+		assert (status2 == 0);
+	}
 	assert (block_a.previous ().is_zero () || block_successor (transaction_a, block_a.previous ()) == hash_a);
 }
 
@@ -917,7 +1090,7 @@ MDB_val raze::block_store::block_get_raw (MDB_txn * transaction_a, raze::block_h
 	return result;
 }
 
-std::unique_ptr<raze::block> raze::block_store::block_random (MDB_txn * transaction_a, MDB_dbi database)
+std::shared_ptr<raze::block> raze::block_store::block_random (MDB_txn * transaction_a, MDB_dbi database)
 {
 	raze::block_hash hash;
 	raze::random_pool.GenerateBlock (hash.bytes.data (), hash.bytes.size ());
@@ -930,11 +1103,11 @@ std::unique_ptr<raze::block> raze::block_store::block_random (MDB_txn * transact
 	return block_get (transaction_a, raze::block_hash (existing->first.uint256 ()));
 }
 
-std::unique_ptr<raze::block> raze::block_store::block_random (MDB_txn * transaction_a)
+std::shared_ptr<raze::block> raze::block_store::block_random (MDB_txn * transaction_a)
 {
 	auto count (block_count (transaction_a));
 	auto region (raze::random_pool.GenerateWord32 (0, count.sum () - 1));
-	std::unique_ptr<raze::block> result;
+	std::shared_ptr<raze::block> result;
 	if (region < count.send)
 	{
 		result = block_random (transaction_a, send_blocks);
@@ -965,15 +1138,13 @@ std::unique_ptr<raze::block> raze::block_store::block_random (MDB_txn * transact
 
 raze::block_hash raze::block_store::block_successor (MDB_txn * transaction_a, raze::block_hash const & hash_a)
 {
-	raze::block_type type;
-	auto value (block_get_raw (transaction_a, hash_a, type));
+	raze::mdb_val value;
+	auto status (mdb_get (transaction_a, successors, raze::mdb_val (hash_a), value));
+	assert (status == 0 || status == MDB_NOTFOUND);
 	raze::block_hash result;
-	if (value.mv_size != 0)
+	if (status == 0)
 	{
-		assert (value.mv_size >= result.bytes.size ());
-		raze::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data) + value.mv_size - result.bytes.size (), result.bytes.size ());
-		auto error (raze::read (stream, result.bytes));
-		assert (!error);
+		result = value.uint256 ();
 	}
 	else
 	{
@@ -984,20 +1155,27 @@ raze::block_hash raze::block_store::block_successor (MDB_txn * transaction_a, ra
 
 void raze::block_store::block_successor_clear (MDB_txn * transaction_a, raze::block_hash const & hash_a)
 {
-	auto block (block_get (transaction_a, hash_a));
-	block_put (transaction_a, hash_a, *block);
+	auto status (mdb_del (transaction_a, successors, raze::mdb_val (hash_a), nullptr));
+	assert (status == 0 || status == MDB_NOTFOUND);
 }
 
-std::unique_ptr<raze::block> raze::block_store::block_get (MDB_txn * transaction_a, raze::block_hash const & hash_a)
+std::shared_ptr<raze::block> raze::block_store::block_get (MDB_txn * transaction_a, raze::block_hash const & hash_a)
 {
-	raze::block_type type;
-	auto value (block_get_raw (transaction_a, hash_a, type));
-	std::unique_ptr<raze::block> result;
-	if (value.mv_size != 0)
+	auto result (read_only ? nullptr : blocks_cache.get (transaction_a, hash_a));
+	if (result == nullptr)
 	{
-		raze::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data), value.mv_size);
-		result = raze::deserialize_block (stream, type);
-		assert (result != nullptr);
+		raze::block_type type;
+		auto value (block_get_raw (transaction_a, hash_a, type));
+		if (value.mv_size != 0)
+		{
+			raze::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data), value.mv_size);
+			result = raze::deserialize_block (stream, type);
+			assert (result != nullptr);
+			if (!read_only)
+			{
+				blocks_cache.insert (transaction_a, hash_a, result);
+			}
+		}
 	}
 	return result;
 }
@@ -1021,30 +1199,35 @@ void raze::block_store::block_del (MDB_txn * transaction_a, raze::block_hash con
 			}
 		}
 	}
+	block_successor_clear (transaction_a, hash_a);
+	blocks_cache.del (transaction_a, hash_a);
 }
 
 bool raze::block_store::block_exists (MDB_txn * transaction_a, raze::block_hash const & hash_a)
 {
-	auto exists (true);
-	raze::mdb_val junk;
-	auto status (mdb_get (transaction_a, send_blocks, raze::mdb_val (hash_a), junk));
-	assert (status == 0 || status == MDB_NOTFOUND);
-	exists = status == 0;
+	auto exists (!read_only && blocks_cache.get (transaction_a, hash_a) != nullptr);
 	if (!exists)
 	{
-		auto status (mdb_get (transaction_a, receive_blocks, raze::mdb_val (hash_a), junk));
+		raze::mdb_val junk;
+		auto status (mdb_get (transaction_a, send_blocks, raze::mdb_val (hash_a), junk));
 		assert (status == 0 || status == MDB_NOTFOUND);
 		exists = status == 0;
 		if (!exists)
 		{
-			auto status (mdb_get (transaction_a, open_blocks, raze::mdb_val (hash_a), junk));
+			auto status (mdb_get (transaction_a, receive_blocks, raze::mdb_val (hash_a), junk));
 			assert (status == 0 || status == MDB_NOTFOUND);
 			exists = status == 0;
 			if (!exists)
 			{
-				auto status (mdb_get (transaction_a, change_blocks, raze::mdb_val (hash_a), junk));
+				auto status (mdb_get (transaction_a, open_blocks, raze::mdb_val (hash_a), junk));
 				assert (status == 0 || status == MDB_NOTFOUND);
 				exists = status == 0;
+				if (!exists)
+				{
+					auto status (mdb_get (transaction_a, change_blocks, raze::mdb_val (hash_a), junk));
+					assert (status == 0 || status == MDB_NOTFOUND);
+					exists = status == 0;
+				}
 			}
 		}
 	}
@@ -1104,58 +1287,122 @@ std::unordered_multimap<raze::block_hash, raze::block_hash> raze::block_store::b
 
 void raze::block_store::account_del (MDB_txn * transaction_a, raze::account const & account_a)
 {
-	auto status (mdb_del (transaction_a, accounts, raze::mdb_val (account_a), nullptr));
-	assert (status == 0);
+	account_cache.modified (transaction_a, account_a);
+	auto buffer (write_buffer_get (transaction_a));
+	if (buffer != nullptr)
+	{
+		buffer->accounts[account_a] = boost::none;
+	}
+	else
+	{
+		auto status (mdb_del (transaction_a, accounts, raze::mdb_val (account_a), nullptr));
+		assert (status == 0);
+	}
 }
 
 bool raze::block_store::account_exists (MDB_txn * transaction_a, raze::account const & account_a)
 {
-	auto iterator (latest_begin (transaction_a, account_a));
-	return iterator != raze::store_iterator (nullptr) && raze::account (iterator->first.uint256 ()) == account_a;
+	bool result;
+	auto buffer (write_buffer_get (transaction_a));
+	if (buffer != nullptr && buffer->accounts.count (account_a) != 0)
+	{
+		result = buffer->accounts.at (account_a).is_initialized ();
+	}
+	else
+	{
+		auto iterator (latest_begin (transaction_a, account_a));
+		result = iterator != raze::store_iterator (nullptr) && raze::account (iterator->first.uint256 ()) == account_a;
+	}
+	return result;
 }
 
 bool raze::block_store::account_get (MDB_txn * transaction_a, raze::account const & account_a, raze::account_info & info_a)
 {
-	raze::mdb_val value;
-	auto status (mdb_get (transaction_a, accounts, raze::mdb_val (account_a), value));
-	assert (status == 0 || status == MDB_NOTFOUND);
 	bool result;
-	if (status == MDB_NOTFOUND)
+	auto buffer (write_buffer_get (transaction_a));
+	if (buffer != nullptr && buffer->accounts.count (account_a) != 0)
 	{
-		result = true;
+		auto & existing (buffer->accounts.at (account_a));
+		result = !existing.is_initialized ();
+		if (!result)
+		{
+			info_a = existing.get ();
+		}
+	}
+	else if (read_only || account_cache.get (transaction_a, account_a, info_a))
+	{
+		raze::mdb_val value;
+		auto status (mdb_get (transaction_a, accounts, raze::mdb_val (account_a), value));
+		assert (status == 0 || status == MDB_NOTFOUND);
+		if (status == MDB_NOTFOUND)
+		{
+			result = true;
+		}
+		else
+		{
+			raze::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
+			result = info_a.deserialize (stream);
+			assert (!result);
+			if (!read_only)
+			{
+				account_cache.insert (transaction_a, account_a, info_a);
+			}
+		}
 	}
 	else
 	{
-		raze::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
-		result = info_a.deserialize (stream);
-		assert (!result);
+		result = false;
 	}
 	return result;
 }
 
 void raze::block_store::frontier_put (MDB_txn * transaction_a, raze::block_hash const & block_a, raze::account const & account_a)
 {
-	auto status (mdb_put (transaction_a, frontiers, raze::mdb_val (block_a), raze::mdb_val (account_a), 0));
-	assert (status == 0);
+	auto buffer (write_buffer_get (transaction_a));
+	if (buffer != nullptr)
+	{
+		buffer->frontiers[block_a] = account_a;
+	}
+	else
+	{
+		auto status (mdb_put (transaction_a, frontiers, raze::mdb_val (block_a), raze::mdb_val (account_a), 0));
+		assert (status == 0);
+	}
 }
 
 raze::account raze::block_store::frontier_get (MDB_txn * transaction_a, raze::block_hash const & block_a)
 {
-	raze::mdb_val value;
-	auto status (mdb_get (transaction_a, frontiers, raze::mdb_val (block_a), value));
-	assert (status == 0 || status == MDB_NOTFOUND);
 	raze::account result (0);
-	if (status == 0)
+	auto buffer (write_buffer_get (transaction_a));
+	if (buffer != nullptr && buffer->frontiers.count (block_a) != 0)
 	{
-		result = value.uint256 ();
+		result = buffer->frontiers.at (block_a);
+	}
+	else
+	{
+		raze::mdb_val value;
+		auto status (mdb_get (transaction_a, frontiers, raze::mdb_val (block_a), value));
+		assert (status == 0 || status == MDB_NOTFOUND);
+		if (status == 0)
+		{
+			result = value.uint256 ();
+		}
 	}
 	return result;
 }
 
 void raze::block_store::frontier_del (MDB_txn * transaction_a, raze::block_hash const & block_a)
 {
-	auto status (mdb_del (transaction_a, frontiers, raze::mdb_val (block_a), nullptr));
-	assert (status == 0);
+	auto buffer (write_buffer_get (transaction_a));
+	if (buffer != nullptr)
+	{
+		buffer->frontiers[block_a] = raze::account (0);
+	}
+	else
+	{
+		auto status (mdb_del (transaction_a, frontiers, raze::mdb_val (block_a), nullptr));
+		assert (status == 0);
+	}
 }
 
 size_t raze::block_store::frontier_count (MDB_txn * transaction_a)
@@ -1169,76 +1416,388 @@ size_t raze::block_store::frontier_count (MDB_txn * transaction_a)
 
 void raze::block_store::account_put (MDB_txn * transaction_a, raze::account const & account_a, raze::account_info const & info_a)
 {
-	auto status (mdb_put (transaction_a, accounts, raze::mdb_val (account_a), info_a.val (), 0));
-	assert (status == 0);
+	account_cache.modified (transaction_a, account_a);
+	auto buffer (write_buffer_get (transaction_a));
+	if (buffer != nullptr)
+	{
+		buffer->accounts[account_a] = info_a;
+	}
+	else
+	{
+		auto status (mdb_put (transaction_a, accounts, raze::mdb_val (account_a), info_a.val (), 0));
+		assert (status == 0);
+	}
 }
 
-void raze::block_store::pending_put (MDB_txn * transaction_a, raze::pending_key const & key_a, raze::pending_info const & pending_a)
+raze::account_info_cache_shard::account_info_cache_shard () :
+floor (0)
 {
-	auto status (mdb_put (transaction_a, pending, key_a.val (), pending_a.val (), 0));
-	assert (status == 0);
 }
 
-void raze::block_store::pending_del (MDB_txn * transaction_a, raze::pending_key const & key_a)
+raze::account_info_cache::account_info_cache (size_t max_a) :
+shard_max (std::max<size_t> (max_a / shard_count, 1))
 {
-	auto status (mdb_del (transaction_a, pending, key_a.val (), nullptr));
-	assert (status == 0);
 }
 
-bool raze::block_store::pending_exists (MDB_txn * transaction_a, raze::pending_key const & key_a)
+raze::account_info_cache_shard & raze::account_info_cache::shard (raze::account const & account_a)
 {
-	auto iterator (pending_begin (transaction_a, key_a));
-	return iterator != raze::store_iterator (nullptr) && raze::pending_key (iterator->first) == key_a;
+	return shards[account_a.qwords[0] % shard_count];
 }
 
-bool raze::block_store::pending_get (MDB_txn * transaction_a, raze::pending_key const & key_a, raze::pending_info & pending_a)
+bool raze::account_info_cache::get (MDB_txn * transaction_a, raze::account const & account_a, raze::account_info & info_a)
 {
-	raze::mdb_val value;
-	auto status (mdb_get (transaction_a, pending, key_a.val (), value));
-	assert (status == 0 || status == MDB_NOTFOUND);
-	bool result;
-	if (status == MDB_NOTFOUND)
+	uint64_t snapshot (mdb_txn_id (transaction_a));
+	auto & shard_l (shard (account_a));
+	std::lock_guard<std::mutex> lock (shard_l.mutex);
+	auto & accounts (shard_l.entries.get<1> ());
+	auto existing (accounts.find (account_a));
+	auto result (existing == accounts.end () || existing->tombstone || existing->id > snapshot);
+	if (!result)
 	{
-		result = true;
+		info_a = existing->info;
+		shard_l.entries.relocate (shard_l.entries.end (), shard_l.entries.project<0> (existing));
 	}
-	else
+	return result;
+}
+
+void raze::account_info_cache::insert (MDB_txn * transaction_a, raze::account const & account_a, raze::account_info const & info_a)
+{
+	uint64_t snapshot (mdb_txn_id (transaction_a));
+	auto & shard_l (shard (account_a));
+	std::lock_guard<std::mutex> lock (shard_l.mutex);
+	auto & accounts (shard_l.entries.get<1> ());
+	auto existing (accounts.find (account_a));
+	if (existing == accounts.end ())
 	{
-		result = false;
-		assert (value.size () == sizeof (pending_a.source.bytes) + sizeof (pending_a.amount.bytes));
-		raze::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
-		auto error1 (raze::read (stream, pending_a.source));
-		assert (!error1);
-		auto error2 (raze::read (stream, pending_a.amount));
-		assert (!error2);
+		// The account may have been modified by a transaction whose tombstone was evicted
+		if (snapshot > shard_l.floor)
+		{
+			shard_l.entries.push_back ({ account_a, snapshot, false, info_a });
+			evict (shard_l);
+		}
+	}
+	else if (snapshot > existing->id)
+	{
+		// A snapshot with the same id as a tombstone may be the modifying transaction itself, so require a newer one
+		accounts.replace (existing, { account_a, snapshot, false, info_a });
+		shard_l.entries.relocate (shard_l.entries.end (), shard_l.entries.project<0> (existing));
 	}
-	return result;
 }
 
-raze::store_iterator raze::block_store::pending_begin (MDB_txn * transaction_a, raze::pending_key const & key_a)
+void raze::account_info_cache::modified (MDB_txn * transaction_a, raze::account const & account_a)
 {
-	raze::store_iterator result (transaction_a, pending, key_a.val ());
-	return result;
+	uint64_t id (mdb_txn_id (transaction_a));
+	auto & shard_l (shard (account_a));
+	std::lock_guard<std::mutex> lock (shard_l.mutex);
+	auto & accounts (shard_l.entries.get<1> ());
+	auto existing (accounts.find (account_a));
+	if (existing == accounts.end ())
+	{
+		shard_l.entries.push_back ({ account_a, id, true, raze::account_info () });
+		evict (shard_l);
+	}
+	else
+	{
+		accounts.replace (existing, { account_a, std::max (id, existing->id), true, raze::account_info () });
+		shard_l.entries.relocate (shard_l.entries.end (), shard_l.entries.project<0> (existing));
+	}
 }
 
-raze::store_iterator raze::block_store::pending_begin (MDB_txn * transaction_a)
+void raze::account_info_cache::evict (raze::account_info_cache_shard & shard_a)
 {
-	raze::store_iterator result (transaction_a, pending);
-	return result;
+	while (shard_a.entries.size () > shard_max)
+	{
+		auto & oldest (shard_a.entries.front ());
+		if (oldest.tombstone)
+		{
+			shard_a.floor = std::max (shard_a.floor, oldest.id);
+		}
+		shard_a.entries.pop_front ();
+	}
 }
 
-raze::store_iterator raze::block_store::pending_end ()
+void raze::account_info_cache::clear (MDB_txn * transaction_a)
 {
-	raze::store_iterator result (nullptr);
-	return result;
+	clear (mdb_txn_id (transaction_a));
 }
 
-raze::pending_info::pending_info () :
-source (0),
-amount (0)
+void raze::account_info_cache::clear (uint64_t id)
 {
+	for (auto & i : shards)
+	{
+		std::lock_guard<std::mutex> lock (i.mutex);
+		for (auto & j : i.entries)
+		{
+			if (j.tombstone)
+			{
+				i.floor = std::max (i.floor, j.id);
+			}
+		}
+		i.floor = std::max (i.floor, id);
+		i.entries.clear ();
+	}
 }
 
-raze::pending_info::pending_info (MDB_val const & val_a)
+raze::block_cache_shard::block_cache_shard () :
+floor (0)
+{
+}
+
+raze::block_cache::block_cache (size_t max_a) :
+shard_max (std::max<size_t> (max_a / shard_count, 1))
+{
+}
+
+raze::block_cache_shard & raze::block_cache::shard (raze::block_hash const & hash_a)
+{
+	return shards[hash_a.qwords[0] % shard_count];
+}
+
+std::shared_ptr<raze::block> raze::block_cache::get (MDB_txn * transaction_a, raze::block_hash const & hash_a)
+{
+	uint64_t snapshot (mdb_txn_id (transaction_a));
+	auto & shard_l (shard (hash_a));
+	std::lock_guard<std::mutex> lock (shard_l.mutex);
+	auto & hashes (shard_l.entries.get<1> ());
+	auto existing (hashes.find (hash_a));
+	std::shared_ptr<raze::block> result;
+	if (existing != hashes.end () && existing->block != nullptr && existing->id <= snapshot)
+	{
+		result = existing->block;
+		shard_l.entries.relocate (shard_l.entries.end (), shard_l.entries.project<0> (existing));
+	}
+	return result;
+}
+
+void raze::block_cache::insert (MDB_txn * transaction_a, raze::block_hash const & hash_a, std::shared_ptr<raze::block> block_a)
+{
+	uint64_t snapshot (mdb_txn_id (transaction_a));
+	auto & shard_l (shard (hash_a));
+	std::lock_guard<std::mutex> lock (shard_l.mutex);
+	auto & hashes (shard_l.entries.get<1> ());
+	auto existing (hashes.find (hash_a));
+	if (existing == hashes.end ())
+	{
+		if (snapshot > shard_l.floor)
+		{
+			shard_l.entries.push_back ({ hash_a, snapshot, block_a });
+			evict (shard_l);
+		}
+	}
+	else if (existing->block == nullptr && snapshot > existing->id)
+	{
+		// A snapshot with the same id as a tombstone may be the deleting transaction itself, so require a newer one
+		hashes.replace (existing, { hash_a, snapshot, block_a });
+		shard_l.entries.relocate (shard_l.entries.end (), shard_l.entries.project<0> (existing));
+	}
+}
+
+void raze::block_cache::put (MDB_txn * transaction_a, raze::block_hash const & hash_a, std::shared_ptr<raze::block> block_a)
+{
+	uint64_t id (mdb_txn_id (transaction_a));
+	auto & shard_l (shard (hash_a));
+	std::lock_guard<std::mutex> lock (shard_l.mutex);
+	auto & hashes (shard_l.entries.get<1> ());
+	auto existing (hashes.find (hash_a));
+	if (existing == hashes.end ())
+	{
+		shard_l.entries.push_back ({ hash_a, id, block_a });
+		evict (shard_l);
+	}
+	else
+	{
+		hashes.replace (existing, { hash_a, std::max (id, existing->id), block_a });
+		shard_l.entries.relocate (shard_l.entries.end (), shard_l.entries.project<0> (existing));
+	}
+}
+
+void raze::block_cache::del (MDB_txn * transaction_a, raze::block_hash const & hash_a)
+{
+	uint64_t id (mdb_txn_id (transaction_a));
+	auto & shard_l (shard (hash_a));
+	std::lock_guard<std::mutex> lock (shard_l.mutex);
+	auto & hashes (shard_l.entries.get<1> ());
+	auto existing (hashes.find (hash_a));
+	if (existing == hashes.end ())
+	{
+		shard_l.entries.push_back ({ hash_a, id, nullptr });
+		evict (shard_l);
+	}
+	else
+	{
+		hashes.replace (existing, { hash_a, std::max (id, existing->id), nullptr });
+		shard_l.entries.relocate (shard_l.entries.end (), shard_l.entries.project<0> (existing));
+	}
+}
+
+void raze::block_cache::clear (uint64_t id)
+{
+	for (auto & i : shards)
+	{
+		std::lock_guard<std::mutex> lock (i.mutex);
+		for (auto & j : i.entries)
+		{
+			if (j.block == nullptr)
+			{
+				i.floor = std::max (i.floor, j.id);
+			}
+		}
+		i.floor = std::max (i.floor, id);
+		i.entries.clear ();
+	}
+}
+
+void raze::block_cache::evict (raze::block_cache_shard & shard_a)
+{
+	while (shard_a.entries.size () > shard_max)
+	{
+		auto & oldest (shard_a.entries.front ());
+		if (oldest.block == nullptr)
+		{
+			shard_a.floor = std::max (shard_a.floor, oldest.id);
+		}
+		shard_a.entries.pop_front ();
+	}
+}
+
+raze::store_write_buffer * raze::block_store::write_buffer_get (MDB_txn * transaction_a)
+{
+	auto result (write_buffer.load ());
+	if (result != nullptr && result->transaction != transaction_a)
+	{
+		result = nullptr;
+	}
+	return result;
+}
+
+raze::store_write_buffer::store_write_buffer (raze::block_store & store_a, MDB_txn * transaction_a) :
+store (store_a),
+transaction (transaction_a)
+{
+	raze::store_write_buffer * expected (nullptr);
+	auto attached (store.write_buffer.compare_exchange_strong (expected, this));
+	assert (attached);
+}
+
+raze::store_write_buffer::~store_write_buffer ()
+{
+	apply ();
+	store.write_buffer = nullptr;
+}
+
+// Write out everything buffered in key order, the buffer stays attached for further writes
+void raze::store_write_buffer::apply ()
+{
+	for (auto & i : accounts)
+	{
+		if (i.second.is_initialized ())
+		{
+			auto status (mdb_put (transaction, store.accounts, raze::mdb_val (i.first), i.second->val (), 0));
+			assert (status == 0);
+		}
+		else
+		{
+			auto status (mdb_del (transaction, store.accounts, raze::mdb_val (i.first), nullptr));
+			assert (status == 0 || status == MDB_NOTFOUND);
+		}
+	}
+	accounts.clear ();
+	for (auto & i : frontiers)
+	{
+		if (!i.second.is_zero ())
+		{
+			auto status (mdb_put (transaction, store.frontiers, raze::mdb_val (i.first), raze::mdb_val (i.second), 0));
+			assert (status == 0);
+		}
+		else
+		{
+			auto status (mdb_del (transaction, store.frontiers, raze::mdb_val (i.first), nullptr));
+			assert (status == 0 || status == MDB_NOTFOUND);
+		}
+	}
+	frontiers.clear ();
+	for (auto & i : representation)
+	{
+		raze::uint128_union rep (i.second);
+		auto status (mdb_put (transaction, store.representation, raze::mdb_val (i.first), raze::mdb_val (rep), 0));
+		assert (status == 0);
+	}
+	representation.clear ();
+	for (auto & i : checksums)
+	{
+		auto key (i.first);
+		auto status (mdb_put (transaction, store.checksum, raze::mdb_val (sizeof (key), &key), raze::mdb_val (i.second), 0));
+		assert (status == 0);
+	}
+	checksums.clear ();
+}
+
+void raze::block_store::pending_put (MDB_txn * transaction_a, raze::pending_key const & key_a, raze::pending_info const & pending_a)
+{
+	auto status (mdb_put (transaction_a, pending, key_a.val (), pending_a.val (), 0));
+	assert (status == 0);
+}
+
+void raze::block_store::pending_del (MDB_txn * transaction_a, raze::pending_key const & key_a)
+{
+	auto status (mdb_del (transaction_a, pending, key_a.val (), nullptr));
+	assert (status == 0);
+}
+
+bool raze::block_store::pending_exists (MDB_txn * transaction_a, raze::pending_key const & key_a)
+{
+	auto iterator (pending_begin (transaction_a, key_a));
+	return iterator != raze::store_iterator (nullptr) && raze::pending_key (iterator->first) == key_a;
+}
+
+bool raze::block_store::pending_get (MDB_txn * transaction_a, raze::pending_key const & key_a, raze::pending_info & pending_a)
+{
+	raze::mdb_val value;
+	auto status (mdb_get (transaction_a, pending, key_a.val (), value));
+	assert (status == 0 || status == MDB_NOTFOUND);
+	bool result;
+	if (status == MDB_NOTFOUND)
+	{
+		result = true;
+	}
+	else
+	{
+		result = false;
+		assert (value.size () == sizeof (pending_a.source.bytes) + sizeof (pending_a.amount.bytes));
+		raze::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
+		auto error1 (raze::read (stream, pending_a.source));
+		assert (!error1);
+		auto error2 (raze::read (stream, pending_a.amount));
+		assert (!error2);
+	}
+	return result;
+}
+
+raze::store_iterator raze::block_store::pending_begin (MDB_txn * transaction_a, raze::pending_key const & key_a)
+{
+	raze::store_iterator result (transaction_a, pending, key_a.val ());
+	return result;
+}
+
+raze::store_iterator raze::block_store::pending_begin (MDB_txn * transaction_a)
+{
+	raze::store_iterator result (transaction_a, pending);
+	return result;
+}
+
+raze::store_iterator raze::block_store::pending_end ()
+{
+	raze::store_iterator result (nullptr);
+	return result;
+}
+
+raze::pending_info::pending_info () :
+source (0),
+amount (0)
+{
+}
+
+raze::pending_info::pending_info (MDB_val const & val_a)
 {
 	assert (val_a.mv_size == sizeof (*this));
 	static_assert (sizeof (source) + sizeof (amount) == sizeof (*this), "Packed class");
@@ -1420,129 +1979,283 @@ raze::mdb_val raze::block_info::val () const
 	return raze::mdb_val (sizeof (*this), const_cast<raze::block_info *> (this));
 }
 
-raze::uint128_t raze::block_store::representation_get (MDB_txn * transaction_a, raze::account const & account_a)
+raze::height_key::height_key (raze::account const & account_a, uint64_t height_a) :
+account (account_a)
 {
-	raze::mdb_val value;
-	auto status (mdb_get (transaction_a, representation, raze::mdb_val (account_a), value));
-	assert (status == 0 || status == MDB_NOTFOUND);
-	raze::uint128_t result;
-	if (status == 0)
+	for (auto i (height_bytes.rbegin ()), n (height_bytes.rend ()); i != n; ++i)
 	{
-		raze::uint128_union rep;
-		raze::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
-		auto error (raze::read (stream, rep));
-		assert (!error);
-		result = rep.number ();
-	}
-	else
-	{
-		result = 0;
+		*i = static_cast<uint8_t> (height_a);
+		height_a >>= 8;
 	}
-	return result;
 }
 
-void raze::block_store::representation_put (MDB_txn * transaction_a, raze::account const & account_a, raze::uint128_t const & representation_a)
+raze::height_key::height_key (MDB_val const & val_a)
 {
-	raze::uint128_union rep (representation_a);
-	auto status (mdb_put (transaction_a, representation, raze::mdb_val (account_a), raze::mdb_val (rep), 0));
-	assert (status == 0);
+	assert (val_a.mv_size == sizeof (*this));
+	static_assert (sizeof (account) + sizeof (height_bytes) == sizeof (*this), "Packed class");
+	std::copy (reinterpret_cast<uint8_t const *> (val_a.mv_data), reinterpret_cast<uint8_t const *> (val_a.mv_data) + sizeof (*this), reinterpret_cast<uint8_t *> (this));
 }
 
-raze::store_iterator raze::block_store::representation_begin (MDB_txn * transaction_a)
+uint64_t raze::height_key::height () const
 {
-	raze::store_iterator result (transaction_a, representation);
+	uint64_t result (0);
+	for (auto i (height_bytes.begin ()), n (height_bytes.end ()); i != n; ++i)
+	{
+		result = (result << 8) | *i;
+	}
 	return result;
 }
 
-raze::store_iterator raze::block_store::representation_end ()
+raze::mdb_val raze::height_key::val () const
 {
-	raze::store_iterator result (nullptr);
-	return result;
+	return raze::mdb_val (sizeof (*this), const_cast<raze::height_key *> (this));
 }
 
-void raze::block_store::unchecked_clear (MDB_txn * transaction_a)
+void raze::block_store::block_height_put (MDB_txn * transaction_a, raze::account const & account_a, uint64_t height_a, raze::block_hash const & hash_a)
 {
-	auto status (mdb_drop (transaction_a, unchecked, 0));
-	assert (status == 0);
+	assert (height_a > 0);
+	auto status1 (mdb_put (transaction_a, block_heights, raze::mdb_val (hash_a), raze::mdb_val (sizeof (height_a), &height_a), 0));
+	assert (status1 == 0);
+	auto status2 (mdb_put (transaction_a, account_heights, raze::height_key (account_a, height_a).val (), raze::mdb_val (hash_a), 0));
+	assert (status2 == 0);
 }
 
-void raze::block_store::unchecked_put (MDB_txn * transaction_a, raze::block_hash const & hash_a, std::shared_ptr<raze::block> const & block_a)
+void raze::block_store::block_height_del (MDB_txn * transaction_a, raze::account const & account_a, uint64_t height_a, raze::block_hash const & hash_a)
 {
-	// Checking if same unchecked block is already in database
-	bool exists (false);
-	auto block_hash (block_a->hash ());
-	auto cached (unchecked_get (transaction_a, hash_a));
-	for (auto i (cached.begin ()), n (cached.end ()); i != n && !exists; ++i)
-	{
-		if ((*i)->hash () == block_hash)
-		{
-			exists = true;
-		}
-	}
-	// Insering block if it wasn't found in database
-	if (!exists)
+	auto status1 (mdb_del (transaction_a, block_heights, raze::mdb_val (hash_a), nullptr));
+	assert (status1 == 0);
+	auto status2 (mdb_del (transaction_a, account_heights, raze::height_key (account_a, height_a).val (), nullptr));
+	assert (status2 == 0);
+	// Rolling back a confirmed block only happens when the ledger is repaired by hand, keep the height inside the chain
+	if (confirmation_height_get (transaction_a, account_a) >= height_a)
 	{
-		std::lock_guard<std::mutex> lock (cache_mutex);
-		unchecked_cache.insert (std::make_pair (hash_a, block_a));
+		confirmation_height_put (transaction_a, account_a, height_a - 1);
 	}
 }
 
-std::vector<std::shared_ptr<raze::block>> raze::block_store::unchecked_get (MDB_txn * transaction_a, raze::block_hash const & hash_a)
+bool raze::block_store::block_height_get (MDB_txn * transaction_a, raze::block_hash const & hash_a, uint64_t & height_a)
 {
-	std::vector<std::shared_ptr<raze::block>> result;
+	raze::mdb_val value;
+	auto status (mdb_get (transaction_a, block_heights, raze::mdb_val (hash_a), value));
+	assert (status == 0 || status == MDB_NOTFOUND);
+	bool result;
+	if (status == MDB_NOTFOUND)
 	{
-		std::lock_guard<std::mutex> lock (cache_mutex);
-		for (auto i (unchecked_cache.find (hash_a)), n (unchecked_cache.end ()); i != n && i->first == hash_a; ++i)
-		{
-			result.push_back (i->second);
-		}
+		result = true;
 	}
-	for (auto i (unchecked_begin (transaction_a, hash_a)), n (unchecked_end ()); i != n && raze::block_hash (i->first.uint256 ()) == hash_a; i.next_dup ())
+	else
 	{
-		raze::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
-		result.push_back (raze::deserialize_block (stream));
+		result = false;
+		assert (value.size () == sizeof (height_a));
+		std::copy (reinterpret_cast<uint8_t const *> (value.data ()), reinterpret_cast<uint8_t const *> (value.data ()) + sizeof (height_a), reinterpret_cast<uint8_t *> (&height_a));
 	}
 	return result;
 }
 
-void raze::block_store::unchecked_del (MDB_txn * transaction_a, raze::block_hash const & hash_a, raze::block const & block_a)
+raze::block_hash raze::block_store::block_at_height (MDB_txn * transaction_a, raze::account const & account_a, uint64_t height_a)
 {
+	raze::mdb_val value;
+	auto status (mdb_get (transaction_a, account_heights, raze::height_key (account_a, height_a).val (), value));
+	assert (status == 0 || status == MDB_NOTFOUND);
+	raze::block_hash result (0);
+	if (status == 0)
 	{
-		std::lock_guard<std::mutex> lock (cache_mutex);
-		for (auto i (unchecked_cache.find (hash_a)), n (unchecked_cache.end ()); i != n && i->first == hash_a;)
-		{
-			if (*i->second == block_a)
-			{
-				i = unchecked_cache.erase (i);
-			}
-			else
-			{
-				++i;
-			}
-		}
-	}
-	std::vector<uint8_t> vector;
-	{
-		raze::vectorstream stream (vector);
-		raze::serialize_block (stream, block_a);
+		result = value.uint256 ();
 	}
-	auto status (mdb_del (transaction_a, unchecked, raze::mdb_val (hash_a), raze::mdb_val (vector.size (), vector.data ())));
-	assert (status == 0 || status == MDB_NOTFOUND);
+	return result;
 }
 
-raze::store_iterator raze::block_store::unchecked_begin (MDB_txn * transaction_a)
+raze::store_iterator raze::block_store::heights_begin (MDB_txn * transaction_a, raze::height_key const & key_a)
 {
-	raze::store_iterator result (transaction_a, unchecked);
+	raze::store_iterator result (transaction_a, account_heights, key_a.val ());
 	return result;
 }
 
-raze::store_iterator raze::block_store::unchecked_begin (MDB_txn * transaction_a, raze::block_hash const & hash_a)
+raze::store_iterator raze::block_store::heights_end ()
 {
-	raze::store_iterator result (transaction_a, unchecked, raze::mdb_val (hash_a));
+	raze::store_iterator result (nullptr);
 	return result;
 }
 
-raze::store_iterator raze::block_store::unchecked_end ()
+uint64_t raze::block_store::confirmation_height_get (MDB_txn * transaction_a, raze::account const & account_a)
+{
+	raze::mdb_val value;
+	auto status (mdb_get (transaction_a, confirmation_height, raze::mdb_val (account_a), value));
+	assert (status == 0 || status == MDB_NOTFOUND);
+	uint64_t result (0);
+	if (status == 0)
+	{
+		assert (value.size () == sizeof (result));
+		std::copy (reinterpret_cast<uint8_t const *> (value.data ()), reinterpret_cast<uint8_t const *> (value.data ()) + sizeof (result), reinterpret_cast<uint8_t *> (&result));
+	}
+	return result;
+}
+
+void raze::block_store::confirmation_height_put (MDB_txn * transaction_a, raze::account const & account_a, uint64_t height_a)
+{
+	if (height_a != 0)
+	{
+		auto status (mdb_put (transaction_a, confirmation_height, raze::mdb_val (account_a), raze::mdb_val (sizeof (height_a), &height_a), 0));
+		assert (status == 0);
+	}
+	else
+	{
+		auto status (mdb_del (transaction_a, confirmation_height, raze::mdb_val (account_a), nullptr));
+		assert (status == 0 || status == MDB_NOTFOUND);
+	}
+}
+
+raze::store_iterator raze::block_store::confirmation_height_begin (MDB_txn * transaction_a)
+{
+	raze::store_iterator result (transaction_a, confirmation_height);
+	return result;
+}
+
+raze::store_iterator raze::block_store::confirmation_height_end ()
+{
+	raze::store_iterator result (nullptr);
+	return result;
+}
+
+raze::uint128_t raze::block_store::representation_get (MDB_txn * transaction_a, raze::account const & account_a)
+{
+	raze::uint128_t result;
+	auto buffer (write_buffer_get (transaction_a));
+	if (buffer != nullptr && buffer->representation.count (account_a) != 0)
+	{
+		result = buffer->representation.at (account_a);
+	}
+	else
+	{
+		raze::mdb_val value;
+		auto status (mdb_get (transaction_a, representation, raze::mdb_val (account_a), value));
+		assert (status == 0 || status == MDB_NOTFOUND);
+		if (status == 0)
+		{
+			raze::uint128_union rep;
+			raze::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
+			auto error (raze::read (stream, rep));
+			assert (!error);
+			result = rep.number ();
+		}
+		else
+		{
+			result = 0;
+		}
+	}
+	return result;
+}
+
+void raze::block_store::representation_put (MDB_txn * transaction_a, raze::account const & account_a, raze::uint128_t const & representation_a)
+{
+	auto buffer (write_buffer_get (transaction_a));
+	if (buffer != nullptr)
+	{
+		buffer->representation[account_a] = representation_a;
+	}
+	else
+	{
+		raze::uint128_union rep (representation_a);
+		auto status (mdb_put (transaction_a, representation, raze::mdb_val (account_a), raze::mdb_val (rep), 0));
+		assert (status == 0);
+	}
+}
+
+raze::store_iterator raze::block_store::representation_begin (MDB_txn * transaction_a)
+{
+	raze::store_iterator result (transaction_a, representation);
+	return result;
+}
+
+raze::store_iterator raze::block_store::representation_end ()
+{
+	raze::store_iterator result (nullptr);
+	return result;
+}
+
+void raze::block_store::unchecked_clear (MDB_txn * transaction_a)
+{
+	auto status (mdb_drop (transaction_a, unchecked, 0));
+	assert (status == 0);
+}
+
+void raze::block_store::unchecked_put (MDB_txn * transaction_a, raze::block_hash const & hash_a, std::shared_ptr<raze::block> const & block_a)
+{
+	// Checking if same unchecked block is already in database
+	bool exists (false);
+	auto block_hash (block_a->hash ());
+	auto cached (unchecked_get (transaction_a, hash_a));
+	for (auto i (cached.begin ()), n (cached.end ()); i != n && !exists; ++i)
+	{
+		if ((*i)->hash () == block_hash)
+		{
+			exists = true;
+		}
+	}
+	// Insering block if it wasn't found in database
+	if (!exists)
+	{
+		std::lock_guard<std::mutex> lock (cache_mutex);
+		unchecked_cache.insert (std::make_pair (hash_a, block_a));
+	}
+}
+
+std::vector<std::shared_ptr<raze::block>> raze::block_store::unchecked_get (MDB_txn * transaction_a, raze::block_hash const & hash_a)
+{
+	std::vector<std::shared_ptr<raze::block>> result;
+	{
+		std::lock_guard<std::mutex> lock (cache_mutex);
+		for (auto i (unchecked_cache.find (hash_a)), n (unchecked_cache.end ()); i != n && i->first == hash_a; ++i)
+		{
+			result.push_back (i->second);
+		}
+	}
+	for (auto i (unchecked_begin (transaction_a, hash_a)), n (unchecked_end ()); i != n && raze::block_hash (i->first.uint256 ()) == hash_a; i.next_dup ())
+	{
+		raze::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
+		result.push_back (raze::deserialize_block (stream));
+	}
+	return result;
+}
+
+void raze::block_store::unchecked_del (MDB_txn * transaction_a, raze::block_hash const & hash_a, raze::block const & block_a)
+{
+	{
+		std::lock_guard<std::mutex> lock (cache_mutex);
+		for (auto i (unchecked_cache.find (hash_a)), n (unchecked_cache.end ()); i != n && i->first == hash_a;)
+		{
+			if (*i->second == block_a)
+			{
+				i = unchecked_cache.erase (i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+	std::vector<uint8_t> vector;
+	{
+		raze::vectorstream stream (vector);
+		raze::serialize_block (stream, block_a);
+	}
+	auto status (mdb_del (transaction_a, unchecked, raze::mdb_val (hash_a), raze::mdb_val (vector.size (), vector.data ())));
+	assert (status == 0 || status == MDB_NOTFOUND);
+}
+
+raze::store_iterator raze::block_store::unchecked_begin (MDB_txn * transaction_a)
+{
+	raze::store_iterator result (transaction_a, unchecked);
+	return result;
+}
+
+raze::store_iterator raze::block_store::unchecked_begin (MDB_txn * transaction_a, raze::block_hash const & hash_a)
+{
+	raze::store_iterator result (transaction_a, unchecked, raze::mdb_val (hash_a));
+	return result;
+}
+
+raze::store_iterator raze::block_store::unchecked_end ()
 {
 	raze::store_iterator result (nullptr);
 	return result;
@@ -1594,28 +2307,45 @@ void raze::block_store::checksum_put (MDB_txn * transaction_a, uint64_t prefix,
 {
 	assert ((prefix & 0xff) == 0);
 	uint64_t key (prefix | mask);
-	auto status (mdb_put (transaction_a, checksum, raze::mdb_val (sizeof (key), &key), raze::mdb_val (hash_a), 0));
-	assert (status == 0);
+	auto buffer (write_buffer_get (transaction_a));
+	if (buffer != nullptr)
+	{
+		buffer->checksums[key] = hash_a;
+	}
+	else
+	{
+		auto status (mdb_put (transaction_a, checksum, raze::mdb_val (sizeof (key), &key), raze::mdb_val (hash_a), 0));
+		assert (status == 0);
+	}
 }
 
 bool raze::block_store::checksum_get (MDB_txn * transaction_a, uint64_t prefix, uint8_t mask, raze::uint256_union & hash_a)
 {
 	assert ((prefix & 0xff) == 0);
 	uint64_t key (prefix | mask);
-	raze::mdb_val value;
-	auto status (mdb_get (transaction_a, checksum, raze::mdb_val (sizeof (key), &key), value));
-	assert (status == 0 || status == MDB_NOTFOUND);
 	bool result;
-	if (status == 0)
+	auto buffer (write_buffer_get (transaction_a));
+	if (buffer != nullptr && buffer->checksums.count (key) != 0)
 	{
 		result = false;
-		raze::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
-		auto error (raze::read (stream, hash_a));
-		assert (!error);
+		hash_a = buffer->checksums.at (key);
 	}
 	else
 	{
-		result = true;
+		raze::mdb_val value;
+		auto status (mdb_get (transaction_a, checksum, raze::mdb_val (sizeof (key), &key), value));
+		assert (status == 0 || status == MDB_NOTFOUND);
+		if (status == 0)
+		{
+			result = false;
+			raze::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
+			auto error (raze::read (stream, hash_a));
+			assert (!error);
+		}
+		else
+		{
+			result = true;
+		}
 	}
 	return result;
 }
@@ -1624,8 +2354,13 @@ void raze::block_store::checksum_del (MDB_txn * transaction_a, uint64_t prefix,
 {
 	assert ((prefix & 0xff) == 0);
 	uint64_t key (prefix | mask);
+	auto buffer (write_buffer_get (transaction_a));
+	if (buffer != nullptr)
+	{
+		buffer->checksums.erase (key);
+	}
 	auto status (mdb_del (transaction_a, checksum, raze::mdb_val (sizeof (key), &key), nullptr));
-	assert (status == 0);
+	assert (status == 0 || (buffer != nullptr && status == MDB_NOTFOUND));
 }
 
 void raze::block_store::flush (MDB_txn * transaction_a)
@@ -1709,6 +2444,16 @@ std::shared_ptr<raze::vote> raze::block_store::vote_generate (MDB_txn * transact
 	return result;
 }
 
+std::shared_ptr<raze::vote> raze::block_store::vote_generate (MDB_txn * transaction_a, raze::account const & account_a, raze::raw_key const & key_a, std::vector<raze::block_hash> const & hashes_a)
+{
+	std::lock_guard<std::mutex> lock (cache_mutex);
+	auto result (vote_current (transaction_a, account_a));
+	uint64_t sequence ((result ? result->sequence : 0) + 1);
+	result = std::make_shared<raze::vote> (account_a, key_a, sequence, hashes_a);
+	vote_cache[account_a] = result;
+	return result;
+}
+
 std::shared_ptr<raze::vote> raze::block_store::vote_max (MDB_txn * transaction_a, std::shared_ptr<raze::vote> vote_a)
 {
 	std::lock_guard<std::mutex> lock (cache_mutex);
@@ -1731,19 +2476,26 @@ raze::vote_result raze::block_store::vote_validate (MDB_txn * transaction_a, std
 	// Reject unsigned votes
 	if (!raze::validate_message (vote_a->account, vote_a->hash (), vote_a->signature))
 	{
-		result.code = raze::vote_code::replay;
-		result.vote = vote_max (transaction_a, vote_a); // Make sure this sequence number is > any we've seen from this account before
-		if (result.vote == vote_a)
-		{
-			result.code = raze::vote_code::vote;
-		}
+		result = vote_validate_sequence (transaction_a, vote_a);
+	}
+	return result;
+}
+
+raze::vote_result raze::block_store::vote_validate_sequence (MDB_txn * transaction_a, std::shared_ptr<raze::vote> vote_a)
+{
+	raze::vote_result result ({ raze::vote_code::replay, 0 });
+	result.vote = vote_max (transaction_a, vote_a); // Make sure this sequence number is > any we've seen from this account before
+	if (result.vote == vote_a)
+	{
+		result.code = raze::vote_code::vote;
 	}
 	return result;
 }
 
 bool raze::vote::operator== (raze::vote const & other_a) const
 {
-	return sequence == other_a.sequence && *block == *other_a.block && account == other_a.account && signature == other_a.signature;
+	auto blocks_equal (block == nullptr ? other_a.block == nullptr : other_a.block != nullptr && *block == *other_a.block);
+	return sequence == other_a.sequence && blocks_equal && hashes == other_a.hashes && account == other_a.account && signature == other_a.signature;
 }
 
 bool raze::vote::operator!= (raze::vote const & other_a) const
@@ -1758,7 +2510,21 @@ std::string raze::vote::to_json () const
 	tree.put ("account", account.to_account ());
 	tree.put ("signature", signature.number ());
 	tree.put ("sequence", std::to_string (sequence));
-	tree.put ("block", block->to_json ());
+	if (block != nullptr)
+	{
+		tree.put ("block", block->to_json ());
+	}
+	if (!hashes.empty ())
+	{
+		boost::property_tree::ptree hashes_l;
+		for (auto & i : hashes)
+		{
+			boost::property_tree::ptree entry;
+			entry.put ("", i.to_string ());
+			hashes_l.push_back (std::make_pair ("", entry));
+		}
+		tree.add_child ("hashes", hashes_l);
+	}
 	boost::property_tree::write_json (stream, tree);
 	return stream.str ();
 }
@@ -2005,6 +2771,7 @@ public:
 		ledger.store.frontier_del (transaction, hash);
 		ledger.store.frontier_put (transaction, block_a.hashables.previous, pending.source);
 		ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
+		ledger.store.block_height_del (transaction, pending.source, info.block_count, hash);
 		if (!(info.block_count % ledger.store.block_info_max))
 		{
 			ledger.store.block_info_del (transaction, hash);
@@ -2026,6 +2793,7 @@ public:
 		ledger.store.frontier_del (transaction, hash);
 		ledger.store.frontier_put (transaction, block_a.hashables.previous, destination_account);
 		ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
+		ledger.store.block_height_del (transaction, destination_account, info.block_count, hash);
 		if (!(info.block_count % ledger.store.block_info_max))
 		{
 			ledger.store.block_info_del (transaction, hash);
@@ -2041,6 +2809,7 @@ public:
 		ledger.store.block_del (transaction, hash);
 		ledger.store.pending_put (transaction, raze::pending_key (destination_account, block_a.hashables.source), { ledger.account (transaction, block_a.hashables.source), amount });
 		ledger.store.frontier_del (transaction, hash);
+		ledger.store.block_height_del (transaction, destination_account, 1, hash);
 	}
 	void change_block (raze::change_block const & block_a) override
 	{
@@ -2058,6 +2827,7 @@ public:
 		ledger.store.frontier_del (transaction, hash);
 		ledger.store.frontier_put (transaction, block_a.hashables.previous, account);
 		ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
+		ledger.store.block_height_del (transaction, account, info.block_count, hash);
 		if (!(info.block_count % ledger.store.block_info_max))
 		{
 			ledger.store.block_info_del (transaction, hash);
@@ -2147,6 +2917,65 @@ raze::process_return raze::ledger::process (MDB_txn * transaction_a, raze::block
 	return processor.result;
 }
 
+std::vector<raze::process_return> raze::ledger::process_batch (MDB_txn * transaction_a, std::vector<std::shared_ptr<raze::block>> const & blocks_a)
+{
+	std::vector<raze::process_return> result (blocks_a.size ());
+	ledger_processor processor (*this, transaction_a);
+	for (auto i : dependency_order (blocks_a))
+	{
+		processor.result = raze::process_return ();
+		blocks_a[i]->visit (processor);
+		result[i] = processor.result;
+	}
+	return result;
+}
+
+std::vector<size_t> raze::ledger::dependency_order (std::vector<std::shared_ptr<raze::block>> const & blocks_a)
+{
+	std::unordered_map<raze::block_hash, size_t> index;
+	for (size_t i (0), n (blocks_a.size ()); i < n; ++i)
+	{
+		index.insert (std::make_pair (blocks_a[i]->hash (), i));
+	}
+	std::vector<size_t> result;
+	result.reserve (blocks_a.size ());
+	// Depth first walk emitting a block once everything it depends on has been emitted, otherwise input order is kept
+	std::vector<bool> visited (blocks_a.size (), false);
+	std::vector<std::pair<size_t, bool>> stack;
+	for (size_t i (0), n (blocks_a.size ()); i < n; ++i)
+	{
+		stack.push_back (std::make_pair (i, false));
+		while (!stack.empty ())
+		{
+			auto current (stack.back ());
+			stack.pop_back ();
+			if (current.second)
+			{
+				result.push_back (current.first);
+			}
+			else if (!visited[current.first])
+			{
+				visited[current.first] = true;
+				stack.push_back (std::make_pair (current.first, true));
+				auto & block (*blocks_a[current.first]);
+				for (auto dependency : { block.source (), block.previous () })
+				{
+					if (!dependency.is_zero ())
+					{
+						auto existing (index.find (dependency));
+						if (existing != index.end () && !visited[existing->second])
+						{
+							stack.push_back (std::make_pair (existing->second, false));
+						}
+					}
+				}
+			}
+		}
+	}
+	assert (result.size () == blocks_a.size ());
+	return result;
+}
+
 // Money supply for heuristically calculating vote percentages
 raze::uint128_t raze::ledger::supply (MDB_txn * transaction_a)
 {
@@ -2178,6 +3007,17 @@ bool raze::ledger::block_exists (raze::block_hash const & hash_a)
 	return result;
 }
 
+bool raze::ledger::block_confirmed (MDB_txn * transaction_a, raze::block_hash const & hash_a)
+{
+	uint64_t height;
+	auto result (!store.block_height_get (transaction_a, hash_a, height));
+	if (result)
+	{
+		result = store.confirmation_height_get (transaction_a, account (transaction_a, hash_a)) >= height;
+	}
+	return result;
+}
+
 std::string raze::ledger::block_text (char const * hash_a)
 {
 	return block_text (raze::block_hash (hash_a));
@@ -2346,9 +3186,15 @@ void raze::ledger::change_latest (MDB_txn * transaction_a, raze::account const &
 	{
 		assert (dynamic_cast<raze::open_block *> (store.block_get (transaction_a, hash_a).get ()) != nullptr);
 		info.open_block = hash_a;
+		info.block_count = 0;
 	}
 	if (!hash_a.is_zero ())
 	{
+		if (block_count_a > info.block_count)
+		{
+			// Appending, rollbacks remove their own height entries
+			store.block_height_put (transaction_a, account_a, block_count_a, hash_a);
+		}
 		info.head = hash_a;
 		info.rep_block = rep_block_a;
 		info.balance = balance_a;
@@ -2370,7 +3216,7 @@ void raze::ledger::change_latest (MDB_txn * transaction_a, raze::account const &
 	}
 }
 
-std::unique_ptr<raze::block> raze::ledger::successor (MDB_txn * transaction_a, raze::block_hash const & block_a)
+std::shared_ptr<raze::block> raze::ledger::successor (MDB_txn * transaction_a, raze::block_hash const & block_a)
 {
 	assert (store.account_exists (transaction_a, block_a) || store.block_exists (transaction_a, block_a));
 	assert (store.account_exists (transaction_a, block_a) || latest (transaction_a, account (transaction_a, block_a)) != block_a);
@@ -2392,12 +3238,12 @@ std::unique_ptr<raze::block> raze::ledger::successor (MDB_txn * transaction_a, r
 	return result;
 }
 
-std::unique_ptr<raze::block> raze::ledger::forked_block (MDB_txn * transaction_a, raze::block const & block_a)
+std::shared_ptr<raze::block> raze::ledger::forked_block (MDB_txn * transaction_a, raze::block const & block_a)
 {
 	assert (!store.block_exists (transaction_a, block_a.hash ()));
 	auto root (block_a.root ());
 	assert (store.block_exists (transaction_a, root) || store.account_exists (transaction_a, root));
-	std::unique_ptr<raze::block> result (store.block_get (transaction_a, store.block_successor (transaction_a, root)));
+	std::shared_ptr<raze::block> result (store.block_get (transaction_a, store.block_successor (transaction_a, root)));
 	if (result == nullptr)
 	{
 		raze::account_info info;
@@ -2589,32 +3435,563 @@ transaction (transaction_a)
 {
 }
 
-raze::vote::vote (raze::vote const & other_a) :
-sequence (other_a.sequence),
-block (other_a.block),
-account (other_a.account),
-signature (other_a.signature)
-{
-}
-
-raze::vote::vote (bool & error_a, raze::stream & stream_a)
+// Follows an account chain block by block, checking each block against the account and the pending table
+class verify_visitor : public raze::block_visitor
 {
-	if (!error_a)
+public:
+	verify_visitor (raze::ledger_verifier & verifier_a, MDB_txn * transaction_a, raze::account const & account_a, raze::ledger_verifier_totals & totals_a) :
+	verifier (verifier_a),
+	transaction (transaction_a),
+	account (account_a),
+	totals (totals_a),
+	balance (0),
+	rep_block (0)
 	{
-		error_a = raze::read (stream_a, account.bytes);
-		if (!error_a)
+	}
+	virtual ~verify_visitor () = default;
+	void send_block (raze::send_block const & block_a) override
+	{
+		auto hash (block_a.hash ());
+		++totals.sends;
+		if (balance >= block_a.hashables.balance.number ())
 		{
-			error_a = raze::read (stream_a, signature.bytes);
-			if (!error_a)
+			auto amount (balance - block_a.hashables.balance.number ());
+			balance = block_a.hashables.balance.number ();
+			raze::pending_info pending;
+			if (!verifier.ledger.store.pending_get (transaction, raze::pending_key (block_a.hashables.destination, hash), pending))
 			{
-				error_a = raze::read (stream_a, sequence);
-				if (!error_a)
+				++totals.pending;
+				if (pending.source != account || pending.amount.number () != amount)
 				{
-					block = raze::deserialize_block (stream_a);
-					error_a = block == nullptr;
+					verifier.anomaly (boost::str (boost::format ("Account %1% send %2%: pending entry has source %3% amount %4%, expected source %1% amount %5%") % account.to_account () % hash.to_string () % pending.source.to_account () % pending.amount.to_string_dec () % raze::amount (amount).to_string_dec ()));
 				}
 			}
 		}
+		else
+		{
+			verifier.anomaly (boost::str (boost::format ("Account %1% send %2%: spends a negative amount") % account.to_account () % hash.to_string ()));
+			balance = block_a.hashables.balance.number ();
+		}
+	}
+	void receive_block (raze::receive_block const & block_a) override
+	{
+		from_source (block_a.hash (), block_a.hashables.source);
+	}
+	void open_block (raze::open_block const & block_a) override
+	{
+		auto hash (block_a.hash ());
+		if (block_a.hashables.account != account)
+		{
+			verifier.anomaly (boost::str (boost::format ("Account %1% open %2%: opens account %3%") % account.to_account () % hash.to_string () % block_a.hashables.account.to_account ()));
+		}
+		if (hash == verifier.genesis_hash)
+		{
+			balance = raze::genesis_amount;
+		}
+		else
+		{
+			from_source (hash, block_a.hashables.source);
+		}
+		rep_block = hash;
+	}
+	void change_block (raze::change_block const & block_a) override
+	{
+		rep_block = block_a.hash ();
+	}
+	void from_source (raze::block_hash const & hash_a, raze::block_hash const & source_a)
+	{
+		++totals.receives;
+		auto source (verifier.ledger.store.block_get (transaction, source_a));
+		if (source != nullptr && source->type () == raze::block_type::send)
+		{
+			auto send (static_cast<raze::send_block *> (source.get ()));
+			if (send->hashables.destination == account)
+			{
+				balance += verifier.ledger.amount (transaction, source_a);
+				if (verifier.ledger.store.pending_exists (transaction, raze::pending_key (account, source_a)))
+				{
+					verifier.anomaly (boost::str (boost::format ("Account %1% block %2%: source %3% is received but still pending") % account.to_account () % hash_a.to_string () % source_a.to_string ()));
+				}
+			}
+			else
+			{
+				verifier.anomaly (boost::str (boost::format ("Account %1% block %2%: source %3% was sent to %4%") % account.to_account () % hash_a.to_string () % source_a.to_string () % send->hashables.destination.to_account ()));
+			}
+		}
+		else
+		{
+			verifier.anomaly (boost::str (boost::format ("Account %1% block %2%: source %3% is not a send block in the ledger") % account.to_account () % hash_a.to_string () % source_a.to_string ()));
+		}
+	}
+	raze::ledger_verifier & verifier;
+	MDB_txn * transaction;
+	raze::account const & account;
+	raze::ledger_verifier_totals & totals;
+	raze::uint128_t balance;
+	raze::block_hash rep_block;
+};
+
+raze::ledger_verifier_totals::ledger_verifier_totals () :
+accounts (0),
+blocks (0),
+sends (0),
+receives (0),
+pending (0),
+checksum (0)
+{
+}
+
+raze::ledger_verifier::ledger_verifier (raze::ledger & ledger_a) :
+ledger (ledger_a),
+genesis_hash (raze::genesis ().hash ()),
+accounts_checked (0),
+blocks_checked (0),
+anomaly_count (0)
+{
+}
+
+void raze::ledger_verifier::anomaly (std::string const & text_a)
+{
+	++anomaly_count;
+	std::lock_guard<std::mutex> lock (mutex);
+	if (anomalies.size () < anomalies_max)
+	{
+		anomalies.push_back (text_a);
+	}
+}
+
+uint64_t raze::ledger_verifier::accounts_total ()
+{
+	raze::transaction transaction (ledger.store.environment, nullptr, false);
+	MDB_stat account_stats;
+	auto status (mdb_stat (transaction, ledger.store.accounts, &account_stats));
+	assert (status == 0);
+	return account_stats.ms_entries;
+}
+
+void raze::ledger_verifier::verify_account (MDB_txn * transaction_a, raze::account const & account_a, raze::account_info const & info_a, raze::ledger_verifier_totals & totals_a)
+{
+	auto account_text (account_a.to_account ());
+	verify_visitor visitor (*this, transaction_a, account_a, totals_a);
+	raze::block_hash previous (0);
+	auto current (info_a.open_block);
+	uint64_t height (0);
+	auto done (false);
+	while (!done)
+	{
+		auto block (ledger.store.block_get (transaction_a, current));
+		if (block != nullptr)
+		{
+			++height;
+			++blocks_checked;
+			if (block->previous () != previous)
+			{
+				anomaly (boost::str (boost::format ("Account %1% block %2%: previous is %3%, chain has %4%") % account_text % current.to_string () % block->previous ().to_string () % previous.to_string ()));
+			}
+			if (raze::validate_message (account_a, current, block->block_signature ()))
+			{
+				anomaly (boost::str (boost::format ("Account %1% block %2%: invalid signature") % account_text % current.to_string ()));
+			}
+			if (raze::work_validate (*block))
+			{
+				anomaly (boost::str (boost::format ("Account %1% block %2%: insufficient work") % account_text % current.to_string ()));
+			}
+			uint64_t stored_height;
+			if (ledger.store.block_height_get (transaction_a, current, stored_height) || stored_height != height)
+			{
+				anomaly (boost::str (boost::format ("Account %1% block %2%: height index does not have height %3%") % account_text % current.to_string () % height));
+			}
+			if (ledger.store.block_at_height (transaction_a, account_a, height) != current)
+			{
+				anomaly (boost::str (boost::format ("Account %1% height %2%: index does not map to %3%") % account_text % height % current.to_string ()));
+			}
+			block->visit (visitor);
+			previous = current;
+			current = ledger.store.block_successor (transaction_a, current);
+			if (previous == info_a.head)
+			{
+				if (!current.is_zero ())
+				{
+					anomaly (boost::str (boost::format ("Account %1% head %2%: has successor %3%") % account_text % previous.to_string () % current.to_string ()));
+				}
+				done = true;
+			}
+			else if (current.is_zero ())
+			{
+				anomaly (boost::str (boost::format ("Account %1% block %2%: chain ends before head %3%") % account_text % previous.to_string () % info_a.head.to_string ()));
+				done = true;
+			}
+			else if (height >= info_a.block_count)
+			{
+				anomaly (boost::str (boost::format ("Account %1% block %2%: chain continues past block count %3%") % account_text % previous.to_string () % info_a.block_count));
+				done = true;
+			}
+		}
+		else
+		{
+			anomaly (boost::str (boost::format ("Account %1% block %2%: missing from the block tables") % account_text % current.to_string ()));
+			done = true;
+		}
+	}
+	if (height != info_a.block_count)
+	{
+		anomaly (boost::str (boost::format ("Account %1%: block count is %2%, chain has %3% blocks") % account_text % info_a.block_count % height));
+	}
+	auto confirmation_height (ledger.store.confirmation_height_get (transaction_a, account_a));
+	if (confirmation_height > info_a.block_count)
+	{
+		anomaly (boost::str (boost::format ("Account %1%: confirmation height %2% is past block count %3%") % account_text % confirmation_height % info_a.block_count));
+	}
+	if (visitor.balance != info_a.balance.number ())
+	{
+		anomaly (boost::str (boost::format ("Account %1%: balance is %2%, chain sums to %3%") % account_text % info_a.balance.to_string_dec () % raze::amount (visitor.balance).to_string_dec ()));
+	}
+	if (visitor.rep_block != info_a.rep_block)
+	{
+		anomaly (boost::str (boost::format ("Account %1%: representative block is %2%, chain has %3%") % account_text % info_a.rep_block.to_string () % visitor.rep_block.to_string ()));
+	}
+	if (ledger.store.frontier_get (transaction_a, info_a.head) != account_a)
+	{
+		anomaly (boost::str (boost::format ("Account %1%: no frontier entry for head %2%") % account_text % info_a.head.to_string ()));
+	}
+	auto rep_block (ledger.store.block_get (transaction_a, info_a.rep_block));
+	if (rep_block != nullptr)
+	{
+		totals_a.representation[rep_block->representative ()] += info_a.balance.number ();
+	}
+	else
+	{
+		anomaly (boost::str (boost::format ("Account %1%: representative block %2% is missing") % account_text % info_a.rep_block.to_string ()));
+	}
+	totals_a.checksum ^= info_a.head;
+	totals_a.blocks += height;
+	++totals_a.accounts;
+}
+
+void raze::ledger_verifier::verify_pending (MDB_txn * transaction_a, raze::pending_key const & key_a, raze::pending_info const & pending_a)
+{
+	auto block (ledger.store.block_get (transaction_a, key_a.hash));
+	if (block != nullptr && block->type () == raze::block_type::send)
+	{
+		auto send (static_cast<raze::send_block *> (block.get ()));
+		if (send->hashables.destination != key_a.account)
+		{
+			anomaly (boost::str (boost::format ("Pending %1% for %2%: send is to %3%") % key_a.hash.to_string () % key_a.account.to_account () % send->hashables.destination.to_account ()));
+		}
+	}
+	else
+	{
+		anomaly (boost::str (boost::format ("Pending %1% for %2%: not a send block in the ledger") % key_a.hash.to_string () % key_a.account.to_account ()));
+	}
+}
+
+void raze::ledger_verifier::verify_frontier (MDB_txn * transaction_a, raze::block_hash const & hash_a, raze::account const & account_a)
+{
+	raze::account_info info;
+	if (ledger.store.account_get (transaction_a, account_a, info) || info.head != hash_a)
+	{
+		anomaly (boost::str (boost::format ("Frontier %1% for %2%: not the account head") % hash_a.to_string () % account_a.to_account ()));
+	}
+}
+
+bool raze::ledger_verifier::verify ()
+{
+	auto ranges (raze::block_store::scan_ranges ());
+	std::vector<raze::ledger_verifier_totals> totals (ranges);
+	ledger.store.parallel_scan (ledger.store.accounts, ranges, [this, &totals](size_t range_a, MDB_txn * transaction_a, raze::mdb_val const & key_a, raze::mdb_val const & value_a) {
+		raze::account_info info (value_a);
+		verify_account (transaction_a, key_a.uint256 (), info, totals[range_a]);
+		++accounts_checked;
+	});
+	std::vector<uint64_t> pending_counts (ranges, 0);
+	ledger.store.parallel_scan (ledger.store.pending, ranges, [this, &pending_counts](size_t range_a, MDB_txn * transaction_a, raze::mdb_val const & key_a, raze::mdb_val const & value_a) {
+		verify_pending (transaction_a, raze::pending_key (key_a), raze::pending_info (value_a));
+		++pending_counts[range_a];
+	});
+	std::vector<uint64_t> frontier_counts (ranges, 0);
+	ledger.store.parallel_scan (ledger.store.frontiers, ranges, [this, &frontier_counts](size_t range_a, MDB_txn * transaction_a, raze::mdb_val const & key_a, raze::mdb_val const & value_a) {
+		verify_frontier (transaction_a, key_a.uint256 (), value_a.uint256 ());
+		++frontier_counts[range_a];
+	});
+	raze::ledger_verifier_totals total;
+	for (auto & i : totals)
+	{
+		total.accounts += i.accounts;
+		total.blocks += i.blocks;
+		total.sends += i.sends;
+		total.receives += i.receives;
+		total.pending += i.pending;
+		total.checksum ^= i.checksum;
+		for (auto & j : i.representation)
+		{
+			total.representation[j.first] += j.second;
+		}
+	}
+	auto pending_count (std::accumulate (pending_counts.begin (), pending_counts.end (), uint64_t (0)));
+	auto frontier_count (std::accumulate (frontier_counts.begin (), frontier_counts.end (), uint64_t (0)));
+	if (total.sends != total.receives + total.pending)
+	{
+		anomaly (boost::str (boost::format ("Ledger: %1% sends, %2% received and %3% pending") % total.sends % total.receives % total.pending));
+	}
+	if (pending_count != total.pending)
+	{
+		anomaly (boost::str (boost::format ("Ledger: %1% pending entries, %2% sends are pending") % pending_count % total.pending));
+	}
+	if (frontier_count != total.accounts)
+	{
+		anomaly (boost::str (boost::format ("Ledger: %1% frontiers for %2% accounts") % frontier_count % total.accounts));
+	}
+	raze::transaction transaction (ledger.store.environment, nullptr, false);
+	auto block_count (ledger.store.block_count (transaction).sum ());
+	if (block_count != total.blocks)
+	{
+		anomaly (boost::str (boost::format ("Ledger: %1% blocks stored, %2% in account chains") % block_count % total.blocks));
+	}
+	raze::checksum checksum;
+	if (!ledger.store.checksum_get (transaction, 0, 0, checksum))
+	{
+		if (checksum != total.checksum)
+		{
+			anomaly (boost::str (boost::format ("Ledger: checksum is %1%, account heads give %2%") % checksum.to_string () % total.checksum.to_string ()));
+		}
+	}
+	else
+	{
+		anomaly ("Ledger: checksum is missing");
+	}
+	for (auto i (ledger.store.representation_begin (transaction)), n (ledger.store.representation_end ()); i != n; ++i)
+	{
+		raze::account representative (i->first.uint256 ());
+		raze::amount weight (ledger.store.representation_get (transaction, representative));
+		auto existing (total.representation.find (representative));
+		raze::amount expected (existing != total.representation.end () ? existing->second : 0);
+		if (weight != expected)
+		{
+			anomaly (boost::str (boost::format ("Representative %1%: weight is %2%, delegated balances sum to %3%") % representative.to_account () % weight.to_string_dec () % expected.to_string_dec ()));
+		}
+		if (existing != total.representation.end ())
+		{
+			total.representation.erase (existing);
+		}
+	}
+	for (auto & i : total.representation)
+	{
+		if (i.second != 0)
+		{
+			anomaly (boost::str (boost::format ("Representative %1%: no weight entry, delegated balances sum to %2%") % i.first.to_account () % raze::amount (i.second).to_string_dec ()));
+		}
+	}
+	return anomaly_count > 0;
+}
+
+raze::export_table::export_table (boost::filesystem::path const & path_a, std::vector<std::pair<std::string, uint8_t>> const & columns_a) :
+columns (columns_a),
+stream (path_a.string (), std::ios::binary | std::ios::trunc),
+rows (0)
+{
+	std::string magic ("razecol1");
+	stream.write (magic.data (), magic.size ());
+	stream.put (static_cast<char> (columns.size ()));
+	for (auto & i : columns)
+	{
+		stream.put (static_cast<char> (i.first.size ()));
+		stream.write (i.first.data (), i.first.size ());
+		stream.put (static_cast<char> (i.second));
+	}
+}
+
+void raze::export_table::write (std::vector<std::vector<uint8_t>> const & columns_a, uint32_t count_a)
+{
+	assert (columns_a.size () == columns.size ());
+	std::array<char, 4> count_bytes;
+	for (size_t i (0); i < count_bytes.size (); ++i)
+	{
+		count_bytes[i] = static_cast<char> (count_a >> (8 * i));
+	}
+	std::lock_guard<std::mutex> lock (mutex);
+	stream.write (count_bytes.data (), count_bytes.size ());
+	for (auto & i : columns_a)
+	{
+		stream.write (reinterpret_cast<char const *> (i.data ()), i.size ());
+	}
+	rows += count_a;
+}
+
+raze::export_rows::export_rows (raze::export_table & table_a) :
+table (table_a),
+columns (table_a.columns.size ()),
+count (0)
+{
+}
+
+raze::export_rows::~export_rows ()
+{
+	flush ();
+}
+
+void raze::export_rows::add (size_t column_a, raze::uint256_union const & value_a)
+{
+	assert (table.columns[column_a].second == value_a.bytes.size ());
+	columns[column_a].insert (columns[column_a].end (), value_a.bytes.begin (), value_a.bytes.end ());
+}
+
+void raze::export_rows::add (size_t column_a, raze::uint128_union const & value_a)
+{
+	assert (table.columns[column_a].second == value_a.bytes.size ());
+	columns[column_a].insert (columns[column_a].end (), value_a.bytes.begin (), value_a.bytes.end ());
+}
+
+void raze::export_rows::add (size_t column_a, uint64_t value_a)
+{
+	assert (table.columns[column_a].second == sizeof (value_a));
+	for (size_t i (0); i < sizeof (value_a); ++i)
+	{
+		columns[column_a].push_back (static_cast<uint8_t> (value_a >> (8 * i)));
+	}
+}
+
+void raze::export_rows::add (size_t column_a, uint8_t value_a)
+{
+	assert (table.columns[column_a].second == sizeof (value_a));
+	columns[column_a].push_back (value_a);
+}
+
+void raze::export_rows::end_row ()
+{
+	++count;
+	if (count >= row_group_max)
+	{
+		flush ();
+	}
+}
+
+void raze::export_rows::flush ()
+{
+	if (count > 0)
+	{
+		table.write (columns, count);
+		for (auto & i : columns)
+		{
+			i.clear ();
+		}
+		count = 0;
+	}
+}
+
+raze::ledger_exporter::ledger_exporter (raze::ledger & ledger_a, boost::filesystem::path const & path_a) :
+ledger (ledger_a),
+path (path_a),
+accounts (0),
+blocks (0),
+pending (0)
+{
+}
+
+void raze::ledger_exporter::export_chain (MDB_txn * transaction_a, raze::account const & account_a, raze::account_info const & info_a, raze::export_rows & rows_a)
+{
+	raze::uint128_t balance (0);
+	uint64_t height (0);
+	auto current (info_a.open_block);
+	while (!current.is_zero ())
+	{
+		auto block (ledger.store.block_get (transaction_a, current));
+		assert (block != nullptr);
+		++height;
+		switch (block->type ())
+		{
+			case raze::block_type::send:
+				balance = static_cast<raze::send_block *> (block.get ())->hashables.balance.number ();
+				break;
+			case raze::block_type::receive:
+			case raze::block_type::open:
+				balance += ledger.amount (transaction_a, current);
+				break;
+			default:
+				break;
+		}
+		rows_a.add (0, current);
+		rows_a.add (1, account_a);
+		rows_a.add (2, height);
+		rows_a.add (3, raze::uint128_union (balance));
+		rows_a.add (4, static_cast<uint8_t> (block->type ()));
+		rows_a.end_row ();
+		current = current == info_a.head ? raze::block_hash (0) : ledger.store.block_successor (transaction_a, current);
+	}
+}
+
+bool raze::ledger_exporter::run ()
+{
+	raze::export_table accounts_table (path / "accounts.col", { { "account", 32 }, { "head", 32 }, { "rep_block", 32 }, { "open_block", 32 }, { "balance", 16 }, { "modified", 8 }, { "block_count", 8 } });
+	raze::export_table blocks_table (path / "blocks.col", { { "hash", 32 }, { "account", 32 }, { "height", 8 }, { "balance", 16 }, { "type", 1 } });
+	raze::export_table pending_table (path / "pending.col", { { "account", 32 }, { "hash", 32 }, { "source", 32 }, { "amount", 16 } });
+	auto result (!accounts_table.stream || !blocks_table.stream || !pending_table.stream);
+	if (!result)
+	{
+		auto ranges (raze::block_store::scan_ranges ());
+		{
+			std::vector<std::unique_ptr<raze::export_rows>> account_rows;
+			std::vector<std::unique_ptr<raze::export_rows>> block_rows;
+			for (size_t i (0); i < ranges; ++i)
+			{
+				account_rows.push_back (std::unique_ptr<raze::export_rows> (new raze::export_rows (accounts_table)));
+				block_rows.push_back (std::unique_ptr<raze::export_rows> (new raze::export_rows (blocks_table)));
+			}
+			ledger.store.parallel_scan (ledger.store.accounts, ranges, [this, &account_rows, &block_rows](size_t range_a, MDB_txn * transaction_a, raze::mdb_val const & key_a, raze::mdb_val const & value_a) {
+				raze::account account (key_a.uint256 ());
+				raze::account_info info (value_a);
+				auto & rows (*account_rows[range_a]);
+				rows.add (0, account);
+				rows.add (1, info.head);
+				rows.add (2, info.rep_block);
+				rows.add (3, info.open_block);
+				rows.add (4, info.balance);
+				rows.add (5, info.modified);
+				rows.add (6, info.block_count);
+				rows.end_row ();
+				export_chain (transaction_a, account, info, *block_rows[range_a]);
+			});
+		}
+		{
+			std::vector<std::unique_ptr<raze::export_rows>> pending_rows;
+			for (size_t i (0); i < ranges; ++i)
+			{
+				pending_rows.push_back (std::unique_ptr<raze::export_rows> (new raze::export_rows (pending_table)));
+			}
+			ledger.store.parallel_scan (ledger.store.pending, ranges, [&pending_rows](size_t range_a, MDB_txn *, raze::mdb_val const & key_a, raze::mdb_val const & value_a) {
+				raze::pending_key key (key_a);
+				raze::pending_info info (value_a);
+				auto & rows (*pending_rows[range_a]);
+				rows.add (0, key.account);
+				rows.add (1, key.hash);
+				rows.add (2, info.source);
+				rows.add (3, info.amount);
+				rows.end_row ();
+			});
+		}
+		accounts_table.stream.flush ();
+		blocks_table.stream.flush ();
+		pending_table.stream.flush ();
+		result = !accounts_table.stream || !blocks_table.stream || !pending_table.stream;
+		accounts = accounts_table.rows;
+		blocks = blocks_table.rows;
+		pending = pending_table.rows;
+	}
+	return result;
+}
+
+raze::vote::vote (raze::vote const & other_a) :
+sequence (other_a.sequence),
+block (other_a.block),
+account (other_a.account),
+signature (other_a.signature)
+{
+}
+
+raze::vote::vote (bool & error_a, raze::stream & stream_a)
+{
+	if (!error_a)
+	{
+		error_a = deserialize (stream_a);
 	}
 }
 
@@ -2631,8 +4008,15 @@ raze::vote::vote (bool & error_a, raze::stream & stream_a, raze::block_type type
 				error_a = raze::read (stream_a, sequence);
 				if (!error_a)
 				{
-					block = raze::deserialize_block (stream_a, type_a);
-					error_a = block == nullptr;
+					if (type_a == raze::block_type::not_a_block)
+					{
+						error_a = deserialize_hashes (stream_a);
+					}
+					else
+					{
+						block = raze::deserialize_block (stream_a, type_a);
+						error_a = block == nullptr;
+					}
 				}
 			}
 		}
@@ -2647,17 +4031,74 @@ signature (raze::sign_message (prv_a, account_a, hash ()))
 {
 }
 
+raze::vote::vote (raze::account const & account_a, raze::raw_key const & prv_a, uint64_t sequence_a, std::vector<raze::block_hash> const & hashes_a) :
+sequence (sequence_a),
+hashes (hashes_a),
+account (account_a),
+signature (raze::sign_message (prv_a, account_a, hash ()))
+{
+	assert (!hashes.empty () && hashes.size () <= max_hashes);
+}
+
 raze::vote::vote (MDB_val const & value_a)
 {
 	raze::bufferstream stream (reinterpret_cast<uint8_t const *> (value_a.mv_data), value_a.mv_size);
-	auto error (raze::read (stream, account.bytes));
+	auto error (deserialize (stream));
 	assert (!error);
-	error = raze::read (stream, signature.bytes);
-	assert (!error);
-	error = raze::read (stream, sequence);
-	assert (!error);
-	block = raze::deserialize_block (stream);
-	assert (block != nullptr);
+}
+
+bool raze::vote::deserialize (raze::stream & stream_a)
+{
+	auto result (raze::read (stream_a, account.bytes));
+	if (!result)
+	{
+		result = raze::read (stream_a, signature.bytes);
+		if (!result)
+		{
+			result = raze::read (stream_a, sequence);
+			if (!result)
+			{
+				raze::block_type type;
+				result = raze::read (stream_a, type);
+				if (!result)
+				{
+					if (type == raze::block_type::not_a_block)
+					{
+						result = deserialize_hashes (stream_a);
+					}
+					else
+					{
+						block = raze::deserialize_block (stream_a, type);
+						result = block == nullptr;
+					}
+				}
+			}
+		}
+	}
+	return result;
+}
+
+void raze::vote::serialize_hashes (raze::stream & stream_a) const
+{
+	write (stream_a, static_cast<uint8_t> (hashes.size ()));
+	for (auto & i : hashes)
+	{
+		write (stream_a, i);
+	}
+}
+
+bool raze::vote::deserialize_hashes (raze::stream & stream_a)
+{
+	uint8_t count;
+	auto result (raze::read (stream_a, count));
+	result = result || count == 0 || count > max_hashes;
+	for (uint8_t i (0); !result && i < count; ++i)
+	{
+		raze::block_hash hash;
+		result = raze::read (stream_a, hash);
+		hashes.push_back (hash);
+	}
+	return result;
 }
 
 raze::uint256_union raze::vote::hash () const
@@ -2665,7 +4106,15 @@ raze::uint256_union raze::vote::hash () const
 	raze::uint256_union result;
 	blake2b_state hash;
 	blake2b_init (&hash, sizeof (result.bytes));
-	blake2b_update (&hash, block->hash ().bytes.data (), sizeof (result.bytes));
+	// A vote for a single hash signs the same digest as a vote carrying that block, both mean the same thing
+	if (hashes.empty ())
+	{
+		blake2b_update (&hash, block->hash ().bytes.data (), sizeof (result.bytes));
+	}
+	for (auto & i : hashes)
+	{
+		blake2b_update (&hash, i.bytes.data (), sizeof (i.bytes));
+	}
 	union
 	{
 		uint64_t qword;
@@ -2677,12 +4126,19 @@ raze::uint256_union raze::vote::hash () const
 	return result;
 }
 
-void raze::vote::serialize (raze::stream & stream_a, raze::block_type)
+void raze::vote::serialize (raze::stream & stream_a, raze::block_type type_a)
 {
 	write (stream_a, account);
 	write (stream_a, signature);
 	write (stream_a, sequence);
-	block->serialize (stream_a);
+	if (type_a == raze::block_type::not_a_block)
+	{
+		serialize_hashes (stream_a);
+	}
+	else
+	{
+		block->serialize (stream_a);
+	}
 }
 
 void raze::vote::serialize (raze::stream & stream_a)
@@ -2690,7 +4146,15 @@ void raze::vote::serialize (raze::stream & stream_a)
 	write (stream_a, account);
 	write (stream_a, signature);
 	write (stream_a, sequence);
-	raze::serialize_block (stream_a, *block);
+	if (!hashes.empty ())
+	{
+		write (stream_a, raze::block_type::not_a_block);
+		serialize_hashes (stream_a);
+	}
+	else
+	{
+		raze::serialize_block (stream_a, *block);
+	}
 }
 
 raze::genesis::genesis ()
@@ -2712,6 +4176,8 @@ void raze::genesis::initialize (MDB_txn * transaction_a, raze::block_store & sto
 	store_a.representation_put (transaction_a, genesis_account, std::numeric_limits<raze::uint128_t>::max ());
 	store_a.checksum_put (transaction_a, 0, 0, hash_l);
 	store_a.frontier_put (transaction_a, hash_l, genesis_account);
+	store_a.block_height_put (transaction_a, genesis_account, 1, hash_l);
+	store_a.confirmation_height_put (transaction_a, genesis_account, 1);
 }
 
 raze::block_hash raze::genesis::hash () const
@@ -3,8 +3,16 @@
 #include <raze/lib/blocks.hpp>
 #include <raze/node/utility.hpp>
 
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/optional.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <fstream>
+#include <mutex>
+
 #include <unordered_map>
 #include <unordered_set>
 
@@ -127,6 +135,18 @@ public:
 	raze::account account;
 	raze::amount balance;
 };
+// Position of a block in its account's chain, the open block has height 1
+class height_key
+{
+public:
+	height_key (raze::account const &, uint64_t);
+	height_key (MDB_val const &);
+	uint64_t height () const;
+	raze::mdb_val val () const;
+	raze::account account;
+	// Stored big endian so an account's entries sort by height
+	std::array<uint8_t, 8> height_bytes;
+};
 class block_counts
 {
 public:
@@ -145,20 +165,30 @@ public:
 	vote (bool &, raze::stream &);
 	vote (bool &, raze::stream &, raze::block_type);
 	vote (raze::account const &, raze::raw_key const &, uint64_t, std::shared_ptr<raze::block>);
+	vote (raze::account const &, raze::raw_key const &, uint64_t, std::vector<raze::block_hash> const &);
 	vote (MDB_val const &);
 	raze::uint256_union hash () const;
 	bool operator== (raze::vote const &) const;
 	bool operator!= (raze::vote const &) const;
+	// Votes by hash are serialized with block type not_a_block
 	void serialize (raze::stream &, raze::block_type);
 	void serialize (raze::stream &);
+	bool deserialize (raze::stream &);
+	void serialize_hashes (raze::stream &) const;
+	bool deserialize_hashes (raze::stream &);
 	std::string to_json () const;
 	// Vote round sequence number
 	uint64_t sequence;
+	// Block being voted for, votes by hash leave this empty until the block is looked up locally
 	std::shared_ptr<raze::block> block;
+	// Hashes of the blocks being voted for when voting by hash
+	std::vector<raze::block_hash> hashes;
 	// Account that's voting
 	raze::account account;
-	// Signature of sequence + block hash
+	// Signature of sequence + block hash, or sequence + each hash when voting by hash
 	raze::signature signature;
+	// Most hashes one vote can carry and still fit in a UDP message
+	static size_t constexpr max_hashes = 12;
 };
 enum class vote_code
 {
@@ -172,10 +202,125 @@ public:
 	raze::vote_code code;
 	std::shared_ptr<raze::vote> vote;
 };
+class account_info_cache_entry
+{
+public:
+	raze::account account;
+	// Snapshot the info was read at or, for tombstones, the transaction that modified the account
+	uint64_t id;
+	bool tombstone;
+	raze::account_info info;
+};
+class account_info_cache_shard
+{
+public:
+	account_info_cache_shard ();
+	std::mutex mutex;
+	// Least recently used first
+	boost::multi_index_container<
+	raze::account_info_cache_entry,
+	boost::multi_index::indexed_by<
+	boost::multi_index::sequenced<>,
+	boost::multi_index::hashed_unique<boost::multi_index::member<raze::account_info_cache_entry, raze::account, &raze::account_info_cache_entry::account>>>>
+	entries;
+	// Highest modifying transaction of any evicted tombstone
+	uint64_t floor;
+};
+/**
+ * Bounded cache of account_info records, sharded by account to spread lock contention.
+ * Writes leave a tombstone tagged with the writing transaction's id and entries are only filled from snapshots newer than the last modification,
+ * so uncommitted or rolled back values are never served to other transactions.
+ */
+class account_info_cache
+{
+public:
+	account_info_cache (size_t);
+	// Returns true on a miss
+	bool get (MDB_txn *, raze::account const &, raze::account_info &);
+	void insert (MDB_txn *, raze::account const &, raze::account_info const &);
+	void modified (MDB_txn *, raze::account const &);
+	void clear (MDB_txn *);
+	// Drop every entry, nothing from snapshots up to the id is cached again
+	void clear (uint64_t);
+	raze::account_info_cache_shard & shard (raze::account const &);
+	void evict (raze::account_info_cache_shard &);
+	static size_t const shard_count = 16;
+	size_t const shard_max;
+	std::array<raze::account_info_cache_shard, shard_count> shards;
+};
+class block_cache_entry
+{
+public:
+	raze::block_hash hash;
+	// Snapshot the block is known to exist from or, for tombstones, the transaction that deleted it
+	uint64_t id;
+	// Null for tombstones
+	std::shared_ptr<raze::block> block;
+};
+class block_cache_shard
+{
+public:
+	block_cache_shard ();
+	std::mutex mutex;
+	// Least recently used first
+	boost::multi_index_container<
+	raze::block_cache_entry,
+	boost::multi_index::indexed_by<
+	boost::multi_index::sequenced<>,
+	boost::multi_index::hashed_unique<boost::multi_index::member<raze::block_cache_entry, raze::block_hash, &raze::block_cache_entry::hash>>>>
+	entries;
+	// Highest deleting transaction of any evicted tombstone
+	uint64_t floor;
+};
+/**
+ * Bounded cache of deserialized blocks, sharded by hash.
+ * Uses the same snapshot tagging as account_info_cache so a reader never sees a block its snapshot doesn't contain.
+ * Blocks written by a transaction are visible from that transaction's id on. If the commit fails the store clears the cache, LMDB reuses the id.
+ */
+class block_cache
+{
+public:
+	block_cache (size_t);
+	// Returns null on a miss
+	std::shared_ptr<raze::block> get (MDB_txn *, raze::block_hash const &);
+	// Fill from a read
+	void insert (MDB_txn *, raze::block_hash const &, std::shared_ptr<raze::block>);
+	// Fill from a write
+	void put (MDB_txn *, raze::block_hash const &, std::shared_ptr<raze::block>);
+	void del (MDB_txn *, raze::block_hash const &);
+	// Drop every entry, nothing from snapshots up to the id is cached again
+	void clear (uint64_t);
+	raze::block_cache_shard & shard (raze::block_hash const &);
+	void evict (raze::block_cache_shard &);
+	static size_t const shard_count = 16;
+	size_t const shard_max;
+	std::array<raze::block_cache_shard, shard_count> shards;
+};
+class block_store;
+/**
+ * Holds account, frontier, checksum and representation writes made through a write transaction, keeping the latest value per key.
+ * Store reads through the same transaction see the buffered values, iterators only see what has been applied.
+ * Declare after the transaction so buffered writes are applied before it commits.
+ */
+class store_write_buffer
+{
+public:
+	store_write_buffer (raze::block_store &, MDB_txn *);
+	~store_write_buffer ();
+	void apply ();
+	raze::block_store & store;
+	MDB_txn * transaction;
+	// Empty values are deletes
+	std::map<raze::account, boost::optional<raze::account_info>> accounts;
+	// Zero accounts are deletes
+	std::map<raze::block_hash, raze::account> frontiers;
+	std::map<raze::account, raze::uint128_t> representation;
+	std::map<uint64_t, raze::checksum> checksums;
+};
 class block_store
 {
 public:
-	block_store (bool &, boost::filesystem::path const &, int lmdb_max_dbs = 128);
+	block_store (bool &, boost::filesystem::path const &, int lmdb_max_dbs = 128, bool read_only = false);
 
 	MDB_dbi block_database (raze::block_type);
 	void block_put_raw (MDB_txn *, MDB_dbi, raze::block_hash const &, MDB_val);
@@ -183,12 +328,14 @@ public:
 	MDB_val block_get_raw (MDB_txn *, raze::block_hash const &, raze::block_type &);
 	raze::block_hash block_successor (MDB_txn *, raze::block_hash const &);
 	void block_successor_clear (MDB_txn *, raze::block_hash const &);
-	std::unique_ptr<raze::block> block_get (MDB_txn *, raze::block_hash const &);
-	std::unique_ptr<raze::block> block_random (MDB_txn *);
-	std::unique_ptr<raze::block> block_random (MDB_txn *, MDB_dbi);
+	std::shared_ptr<raze::block> block_get (MDB_txn *, raze::block_hash const &);
+	std::shared_ptr<raze::block> block_random (MDB_txn *);
+	std::shared_ptr<raze::block> block_random (MDB_txn *, MDB_dbi);
 	void block_del (MDB_txn *, raze::block_hash const &);
 	bool block_exists (MDB_txn *, raze::block_hash const &);
 	raze::block_counts block_count (MDB_txn *);
+	raze::block_cache blocks_cache;
+	static size_t const block_cache_max = 16 * 1024;
 	std::unordered_multimap<raze::block_hash, raze::block_hash> block_dependencies (MDB_txn *);
 
 	void frontier_put (MDB_txn *, raze::block_hash const &, raze::account const &);
@@ -200,6 +347,8 @@ public:
 	bool account_get (MDB_txn *, raze::account const &, raze::account_info &);
 	void account_del (MDB_txn *, raze::account const &);
 	bool account_exists (MDB_txn *, raze::account const &);
+	raze::account_info_cache account_cache;
+	static size_t const account_cache_max = 64 * 1024;
 	raze::store_iterator latest_begin (MDB_txn *, raze::account const &);
 	raze::store_iterator latest_begin (MDB_txn *);
 	raze::store_iterator latest_end ();
@@ -222,6 +371,20 @@ public:
 	raze::uint128_t block_balance (MDB_txn *, raze::block_hash const &);
 	static size_t const block_info_max = 32;
 
+	void block_height_put (MDB_txn *, raze::account const &, uint64_t, raze::block_hash const &);
+	void block_height_del (MDB_txn *, raze::account const &, uint64_t, raze::block_hash const &);
+	bool block_height_get (MDB_txn *, raze::block_hash const &, uint64_t &);
+	// Return the block at height in account's chain or zero if there isn't one
+	raze::block_hash block_at_height (MDB_txn *, raze::account const &, uint64_t);
+	raze::store_iterator heights_begin (MDB_txn *, raze::height_key const &);
+	raze::store_iterator heights_end ();
+
+	// Blocks up to this height in the account chain are confirmed, zero if none are known to be
+	uint64_t confirmation_height_get (MDB_txn *, raze::account const &);
+	void confirmation_height_put (MDB_txn *, raze::account const &, uint64_t);
+	raze::store_iterator confirmation_height_begin (MDB_txn *);
+	raze::store_iterator confirmation_height_end ();
+
 	raze::uint128_t representation_get (MDB_txn *, raze::account const &);
 	void representation_put (MDB_txn *, raze::account const &, raze::uint128_t const &);
 	void representation_add (MDB_txn *, raze::account const &, raze::uint128_t const &);
@@ -250,10 +413,13 @@ public:
 	void checksum_del (MDB_txn *, uint64_t, uint8_t);
 
 	raze::vote_result vote_validate (MDB_txn *, std::shared_ptr<raze::vote>);
+	// Check the sequence number of a vote whose signature has already been verified
+	raze::vote_result vote_validate_sequence (MDB_txn *, std::shared_ptr<raze::vote>);
 	// Return latest vote for an account from store
 	std::shared_ptr<raze::vote> vote_get (MDB_txn *, raze::account const &);
 	// Populate vote with the next sequence number
 	std::shared_ptr<raze::vote> vote_generate (MDB_txn *, raze::account const &, raze::raw_key const &, std::shared_ptr<raze::block>);
+	std::shared_ptr<raze::vote> vote_generate (MDB_txn *, raze::account const &, raze::raw_key const &, std::vector<raze::block_hash> const &);
 	// Return either vote or the stored vote with a higher sequence number
 	std::shared_ptr<raze::vote> vote_max (MDB_txn *, std::shared_ptr<raze::vote>);
 	// Return latest vote for an account considering the vote cache
@@ -264,8 +430,13 @@ public:
 	std::mutex cache_mutex;
 	std::unordered_map<raze::account, std::shared_ptr<raze::vote>> vote_cache;
 
+	raze::store_write_buffer * write_buffer_get (MDB_txn *);
+	// Buffer attached to the current write transaction, if any
+	std::atomic<raze::store_write_buffer *> write_buffer;
+
 	void version_put (MDB_txn *, int);
 	int version_get (MDB_txn *);
+	static int const version_current = 14;
 	void do_upgrades (MDB_txn *);
 	void upgrade_v1_to_v2 (MDB_txn *);
 	void upgrade_v2_to_v3 (MDB_txn *);
@@ -276,9 +447,27 @@ public:
 	void upgrade_v7_to_v8 (MDB_txn *);
 	void upgrade_v8_to_v9 (MDB_txn *);
 	void upgrade_v9_to_v10 (MDB_txn *);
+	void upgrade_v10_to_v11 (MDB_txn *);
+	void upgrade_v11_to_v12 (MDB_txn *);
+	void upgrade_v12_to_v13 (MDB_txn *);
+	void upgrade_v13_to_v14 (MDB_txn *);
+	// Blocks stored their successor in a trailing field up to version 11
+	void block_put_v11 (MDB_txn *, raze::block_hash const &, raze::block const &, raze::block_hash const &);
+	raze::block_hash block_successor_v11 (MDB_txn *, raze::block_hash const &);
 
 	void clear (MDB_dbi);
+	// Visit every entry of a table whose keys start with a 256 bit value, the keyspace is split in to ranges scanned concurrently on their own read transactions
+	// Actions are passed the range index so results can be kept per range and merged after the scan
+	void parallel_scan (MDB_dbi, size_t, std::function<void(size_t, MDB_txn *, raze::mdb_val const &, raze::mdb_val const &)> const &);
+	static size_t scan_ranges ();
+	// Extra threads in use by all running scans, capped at scan_ranges so concurrent RPC scans share the cores. The calling thread always scans as well
+	std::mutex scan_mutex;
+	size_t scan_threads;
+	// Tables with up to this many entries are scanned on the calling thread alone
+	static size_t const scan_sequential_max = 64 * 1024;
 
+	// Opened MDB_RDONLY on an environment another process writes to, the caches are bypassed since they can't see those writes
+	bool const read_only;
 	raze::mdb_env environment;
 	// block_hash -> account                                        // Maps head blocks to owning account
 	MDB_dbi frontiers;
@@ -294,8 +483,16 @@ public:
 	MDB_dbi change_blocks;
 	// block_hash -> sender, amount, destination                    // Pending blocks to sender account, amount, destination account
 	MDB_dbi pending;
+	// block_hash -> block_hash                                     // Next block in the account chain
+	MDB_dbi successors;
 	// block_hash -> account, balance                               // Blocks info
 	MDB_dbi blocks_info;
+	// block_hash -> uint64_t                                       // Height of block in its account chain
+	MDB_dbi block_heights;
+	// account, height -> block_hash                                // Account chain by height
+	MDB_dbi account_heights;
+	// account -> uint64_t                                          // Height of the highest confirmed block in the account chain
+	MDB_dbi confirmation_height;
 	// account -> weight                                            // Representation
 	MDB_dbi representation;
 	// block_hash -> block                                          // Unchecked bootstrap blocks
@@ -360,17 +557,23 @@ public:
 	raze::uint128_t account_balance (MDB_txn *, raze::account const &);
 	raze::uint128_t account_pending (MDB_txn *, raze::account const &);
 	raze::uint128_t weight (MDB_txn *, raze::account const &);
-	std::unique_ptr<raze::block> successor (MDB_txn *, raze::block_hash const &);
-	std::unique_ptr<raze::block> forked_block (MDB_txn *, raze::block const &);
+	std::shared_ptr<raze::block> successor (MDB_txn *, raze::block_hash const &);
+	std::shared_ptr<raze::block> forked_block (MDB_txn *, raze::block const &);
 	raze::block_hash latest (MDB_txn *, raze::account const &);
 	raze::block_hash latest_root (MDB_txn *, raze::account const &);
 	raze::block_hash representative (MDB_txn *, raze::block_hash const &);
 	raze::block_hash representative_calculated (MDB_txn *, raze::block_hash const &);
 	bool block_exists (raze::block_hash const &);
+	// True if the block is in the ledger at or below its account's confirmation height
+	bool block_confirmed (MDB_txn *, raze::block_hash const &);
 	std::string block_text (char const *);
 	std::string block_text (raze::block_hash const &);
 	raze::uint128_t supply (MDB_txn *);
 	raze::process_return process (MDB_txn *, raze::block const &);
+	// Process a batch of blocks in dependency order sharing one processor, results are indexed the same as the input
+	std::vector<raze::process_return> process_batch (MDB_txn *, std::vector<std::shared_ptr<raze::block>> const &);
+	// Indices of blocks ordered so any previous or source block in the batch comes before its dependents
+	static std::vector<size_t> dependency_order (std::vector<std::shared_ptr<raze::block>> const &);
 	void rollback (MDB_txn *, raze::block_hash const &);
 	void change_latest (MDB_txn *, raze::account const &, raze::block_hash const &, raze::account const &, raze::uint128_union const &, uint64_t);
 	void checksum_update (MDB_txn *, raze::block_hash const &);
@@ -383,6 +586,88 @@ public:
 	uint64_t bootstrap_weight_max_blocks;
 	std::atomic<bool> check_bootstrap_weights;
 };
+// Totals gathered from the accounts in one scan range, merged once every range is done
+class ledger_verifier_totals
+{
+public:
+	ledger_verifier_totals ();
+	uint64_t accounts;
+	uint64_t blocks;
+	uint64_t sends;
+	// Receive and open blocks, excluding the genesis open
+	uint64_t receives;
+	// Sends with a pending entry
+	uint64_t pending;
+	raze::checksum checksum;
+	std::unordered_map<raze::account, raze::uint128_t> representation;
+};
+// Walks every account chain concurrently and cross checks it against the tables derived from the chains
+class ledger_verifier
+{
+public:
+	ledger_verifier (raze::ledger &);
+	// Returns true if any anomaly was found
+	bool verify ();
+	void verify_account (MDB_txn *, raze::account const &, raze::account_info const &, raze::ledger_verifier_totals &);
+	void verify_pending (MDB_txn *, raze::pending_key const &, raze::pending_info const &);
+	void verify_frontier (MDB_txn *, raze::block_hash const &, raze::account const &);
+	void anomaly (std::string const &);
+	uint64_t accounts_total ();
+	raze::ledger & ledger;
+	raze::block_hash genesis_hash;
+	std::atomic<uint64_t> accounts_checked;
+	std::atomic<uint64_t> blocks_checked;
+	std::atomic<uint64_t> anomaly_count;
+	std::mutex mutex;
+	// Only the first anomalies_max are kept, anomaly_count has the full number
+	std::vector<std::string> anomalies;
+	static size_t const anomalies_max = 10000;
+};
+// Output file for one table of a ledger export
+// Starts with the magic "razecol1", a column count byte and for each column a name length byte, the name and a width byte
+// The rest of the file is row groups: a little endian uint32 row count followed by the values of each column for those rows, column after column
+// Numbers are written in the byte order they are stored in the ledger, 256 and 128 bit values big endian and heights and timestamps little endian
+class export_table
+{
+public:
+	export_table (boost::filesystem::path const &, std::vector<std::pair<std::string, uint8_t>> const &);
+	void write (std::vector<std::vector<uint8_t>> const &, uint32_t);
+	std::vector<std::pair<std::string, uint8_t>> columns;
+	std::mutex mutex;
+	std::ofstream stream;
+	uint64_t rows;
+};
+// Rows gathered by one scan thread, written to the table a row group at a time
+class export_rows
+{
+public:
+	export_rows (raze::export_table &);
+	~export_rows ();
+	void add (size_t, raze::uint256_union const &);
+	void add (size_t, raze::uint128_union const &);
+	void add (size_t, uint64_t);
+	void add (size_t, uint8_t);
+	void end_row ();
+	void flush ();
+	raze::export_table & table;
+	std::vector<std::vector<uint8_t>> columns;
+	uint32_t count;
+	static uint32_t const row_group_max = 64 * 1024;
+};
+// Writes the accounts, blocks and pending tables to columnar files without going through the RPC
+class ledger_exporter
+{
+public:
+	ledger_exporter (raze::ledger &, boost::filesystem::path const &);
+	// Returns true if an output file couldn't be written
+	bool run ();
+	void export_chain (MDB_txn *, raze::account const &, raze::account_info const &, raze::export_rows &);
+	raze::ledger & ledger;
+	boost::filesystem::path path;
+	uint64_t accounts;
+	uint64_t blocks;
+	uint64_t pending;
+};
 extern raze::keypair const & zero_key;
 extern raze::keypair const & test_genesis_key;
 extern raze::account const & raze_test_account;